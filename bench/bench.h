@@ -0,0 +1,55 @@
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <string>
+#include <chrono>
+#include <iostream>
+
+//Benchmarks register themselves at startup and are all run by "make bench"
+//(or only those whose name contains the first argument of run_bench).
+//They print their own figures through report(). Timings are only
+//meaningful with optimizations on, i.e. when built with
+//	make clean && make bench FLAGS="-O2 -std=c++11 -pthread"
+typedef void (*BenchFunction)();
+
+class BenchRegistrar
+{
+public:
+	BenchRegistrar(const char* name, BenchFunction f);
+};
+
+#define BENCHMARK(name) \
+	static void bench_##name(); \
+	static BenchRegistrar bench_registrar_##name(#name, bench_##name); \
+	static void bench_##name()
+
+//Best wall-clock time, in seconds, of REPEATS runs of F
+template<typename F>
+double best_time(int repeats, F f)
+{
+	double best = 0.0;
+	for(int r = 0; r < repeats; r++)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		f();
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		if(r == 0 || elapsed.count() < best) best = elapsed.count();
+	}
+	return best;
+}
+
+//Prints "WHAT: SECONDS ms (AMOUNT/SECONDS UNIT/s)"
+inline void report(const std::string& what, double seconds, double amount, const std::string& unit)
+{
+	std::cout<<"  "<<what<<": "<<seconds * 1000.0<<" ms ("
+			 <<(seconds > 0.0 ? amount / seconds : 0.0)<<" "<<unit<<"/s)"<<std::endl;
+}
+
+//Keeps the optimizer from dropping a result nobody reads
+template<typename T>
+void keep(const T& value)
+{
+	asm volatile("" : : "g"(&value) : "memory");
+}
+
+#endif
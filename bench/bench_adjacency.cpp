@@ -0,0 +1,109 @@
+#include "bench.h"
+#include "../tests/surfaces.h"
+#include <vector>
+#include <utility>
+
+//------------------------------------------------------
+//--------------------- INTERNAL -----------------------
+//------------------------------------------------------
+//The per-node vectors of incident faces the CSR arrays replaced
+typedef std::vector< std::vector< std::pair<int,int> > > NodeFaces;
+
+static void node_faces(const Graph& g, NodeFaces& adj)
+{
+	adj.assign( g.size(), std::vector< std::pair<int,int> >() );
+	for(unsigned int i = 0; i < g.n_faces(); i++)
+	{
+		Face f = g.get_face(i);
+		adj[f.a].push_back( std::make_pair(f.b, f.c) );
+		adj[f.b].push_back( std::make_pair(f.a, f.c) );
+		adj[f.c].push_back( std::make_pair(f.a, f.b) );
+	}
+}
+
+//Breadth-first searches over the whole surface from node 0, as the
+//patch and contour searches do. They return the number of nodes reached.
+//The old searches went through both vertices of every incident face.
+static int bfs(const NodeFaces& adj, std::vector<char>& visited, std::vector<int>& queue)
+{
+	visited.assign(adj.size(), 0);
+	queue.assign(1, 0);
+	visited[0] = 1;
+
+	for(unsigned int q = 0; q < queue.size(); q++)
+	{
+		const std::vector< std::pair<int,int> >& faces = adj[ queue[q] ];
+		for(auto f = faces.begin(); f != faces.end(); ++f)
+		{
+			if(!visited[f->first]) { visited[f->first] = 1; queue.push_back(f->first); }
+			if(!visited[f->second]) { visited[f->second] = 1; queue.push_back(f->second); }
+		}
+	}
+
+	return queue.size();
+}
+
+static int bfs(const Graph& g, std::vector<char>& visited, std::vector<int>& queue)
+{
+	visited.assign(g.size(), 0);
+	queue.assign(1, 0);
+	visited[0] = 1;
+
+	for(unsigned int q = 0; q < queue.size(); q++)
+	{
+		ConstSpan<int> ngbrs = g.neighbours( queue[q] );
+		for(auto v = ngbrs.begin(); v != ngbrs.end(); ++v)
+			if(!visited[*v]) { visited[*v] = 1; queue.push_back(*v); }
+	}
+
+	return queue.size();
+}
+
+//------------------------------------------------------
+//-------------------- BENCHMARKS ----------------------
+//------------------------------------------------------
+//Building and walking the adjacency of a 500k-node surface
+BENCHMARK(adjacency)
+{
+	Graph g;
+	sphere_surface(500000, 20.0, g);
+	int n = g.size();
+
+	NodeFaces adj;
+	double t = best_time(3, [&g, &adj]() { node_faces(g, adj); });
+	report("build per-node vectors", t, n / 1e6, "Mnodes");
+
+	t = best_time(3, [&g]() { g.build_adjacency(); });
+	report("build CSR (faces + neighbours)", t, n / 1e6, "Mnodes");
+
+	//sum over the incident faces of every node, like compute_curvatures()
+	t = best_time(5, [&g, &adj, n]() {
+		glm::dvec3 acc(0.0);
+		for(int i = 0; i < n; i++)
+			for(auto f = adj[i].begin(); f != adj[i].end(); ++f)
+				acc += g.get_pos(f->first) - g.get_pos(f->second);
+		keep(acc);
+	});
+	report("incident faces, per-node vectors", t, n / 1e6, "Mnodes");
+
+	t = best_time(5, [&g, n]() {
+		glm::dvec3 acc(0.0);
+		for(int i = 0; i < n; i++)
+		{
+			ConstSpan< std::pair<int,int> > faces = g.incident_faces(i);
+			for(auto f = faces.begin(); f != faces.end(); ++f)
+				acc += g.get_pos(f->first) - g.get_pos(f->second);
+		}
+		keep(acc);
+	});
+	report("incident faces, CSR", t, n / 1e6, "Mnodes");
+
+	std::vector<char> visited;
+	std::vector<int> queue;
+
+	t = best_time(3, [&adj, &visited, &queue]() { keep( bfs(adj, visited, queue) ); });
+	report("BFS, per-node vectors", t, n / 1e6, "Mnodes");
+
+	t = best_time(3, [&g, &visited, &queue]() { keep( bfs(g, visited, queue) ); });
+	report("BFS, CSR neighbours", t, n / 1e6, "Mnodes");
+}
@@ -0,0 +1,101 @@
+#include "bench.h"
+#include "../tests/surfaces.h"
+#include "../inc/io/fileio.h"
+#include "../inc/io/mapped_file.h"
+#include "../inc/util/checksum.h"
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+
+//------------------------------------------------------
+//--------------------- INTERNAL -----------------------
+//------------------------------------------------------
+//The getline/stringstream loader mesh_from_file() replaced
+static void getline_load(const std::string& file, Graph& g, bool vertices)
+{
+	std::fstream in(file, std::fstream::in);
+	for(int i = 0; i < 3; i++) in.ignore(256, '\n');
+
+	std::string buffer;
+	while( getline(in, buffer) )
+	{
+		std::stringstream ss(buffer);
+		if(vertices)
+		{
+			double x, y, z, nx, ny, nz;
+			if(ss>>x>>y>>z>>nx>>ny>>nz) g.push_node(x, y, z, nx, ny, nz);
+		}
+		else
+		{
+			int a, b, c;
+			if(ss>>a>>b>>c) g.push_face(a - 1, b - 1, c - 1);
+		}
+	}
+}
+
+static size_t file_size(const std::string& file)
+{
+	std::ifstream in(file, std::ifstream::binary | std::ifstream::ate);
+	return in ? (size_t)in.tellg() : 0;
+}
+
+//------------------------------------------------------
+//-------------------- BENCHMARKS ----------------------
+//------------------------------------------------------
+//Throughput of loading the .vert/.face pair of a 500k-node surface, and
+//of loading it back from its cache
+BENCHMARK(fileio)
+{
+	const std::string base = "bench_surface";
+	{
+		Graph g;
+		sphere_surface(500000, 20.0, g, 0.1, 12);
+		if( !write_msms(g, base) ) { std::cerr<<"Could not write "<<base<<std::endl; return; }
+	}
+
+	double mb = (file_size(base + ".vert") + file_size(base + ".face")) / (1024.0 * 1024.0);
+
+	double t_old = best_time(3, [&base]() {
+		Graph g;
+		getline_load(base + ".vert", g, true);
+		getline_load(base + ".face", g, false);
+		g.build_adjacency();
+		keep(g.size());
+	});
+	report("getline/stringstream", t_old, mb, "MB");
+
+	double t_new = best_time(3, [&base]() {
+		Graph g;
+		FileIO().mesh_from_file(base + ".vert", base + ".face", g);
+		keep(g.size());
+	});
+	report("mesh_from_file", t_new, mb, "MB");
+
+	//the first call preprocesses the surface and writes the cache
+	std::vector< std::pair<Patch, Descriptor> > desc;
+	{
+		Graph g;
+		if( !FileIO().surface_from_file(base, g, desc) ) { std::cerr<<"Could not load "<<base<<std::endl; return; }
+	}
+
+	double t_cache = best_time(3, [&base, &desc]() {
+		Graph g;
+		FileIO().surface_from_file(base, g, desc);
+		keep(g.size());
+	});
+	double cache_mb = file_size(base + ".spdc") / (1024.0 * 1024.0);
+	report("cache hit", t_cache, cache_mb, "MB");
+
+	//what a cache hit can't do without: mapping the file and reading
+	//it all through the checksum
+	double t_floor = best_time(3, [&base]() {
+		MappedFile file;
+		file.open(base + ".spdc");
+		keep( checksum(file.begin(), file.size()) );
+	});
+	report("map + checksum", t_floor, cache_mb, "MB");
+
+	remove( (base + ".vert").c_str() );
+	remove( (base + ".face").c_str() );
+	remove( (base + ".spdc").c_str() );
+}
@@ -0,0 +1,48 @@
+#include "bench.h"
+#include "../tests/surfaces.h"
+#include "../inc/parameters.h"
+#include <thread>
+#include <string>
+#include <algorithm>
+#include <vector>
+
+//------------------------------------------------------
+//-------------------- BENCHMARKS ----------------------
+//------------------------------------------------------
+//Thread scaling of segment_by_curvature() on a bumpy 2M-point sphere,
+//from 1 thread to the number of hardware threads (doubling)
+BENCHMARK(segmentation_threads)
+{
+	Graph g;
+	sphere_surface(2000000, 50.0, g, 0.1, 12);
+	g.build_adjacency();
+	g.compute_curvatures();
+	g.classify_points();
+
+	int n = g.size();
+	int max_threads = std::max(1u, std::thread::hardware_concurrency());
+
+	std::vector<int> counts;
+	for(int t = 1; t < max_threads; t *= 2) counts.push_back(t);
+	counts.push_back(max_threads);
+
+	int saved = Parameters::N_THREADS;
+	double t_serial = 0.0;
+
+	for(auto c = counts.begin(); c != counts.end(); ++c)
+	{
+		Parameters::N_THREADS = *c;
+
+		double t = best_time(3, [&g]() {
+			UnionFind uf( g.size() );
+			g.segment_by_curvature(uf);
+			keep( uf.find(0) );
+		});
+		if(*c == 1) t_serial = t;
+
+		report(std::to_string(*c) + " threads", t, n / 1e6, "Mnodes");
+		std::cout<<"    speedup "<<(t > 0.0 ? t_serial / t : 0.0)<<std::endl;
+	}
+
+	Parameters::N_THREADS = saved;
+}
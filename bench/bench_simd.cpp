@@ -0,0 +1,152 @@
+#include "bench.h"
+#include "../tests/surfaces.h"
+#include "../inc/math/simd_kernels.h"
+#include "../inc/io/fileio.h"
+#include "../inc/parameters.h"
+#include <vector>
+#include <cmath>
+#include <string>
+#include <cstdio>
+#include <glm/gtc/quaternion.hpp>
+
+//------------------------------------------------------
+//--------------------- INTERNAL -----------------------
+//------------------------------------------------------
+//Runs F at every SIMD level the CPU supports, from LOWEST up, reporting
+//AMOUNT UNITs
+template<typename F>
+static void at_each_level(double amount, const std::string& unit, F f, int lowest = SIMD_SCALAR)
+{
+	int saved = Parameters::SIMD_LEVEL;
+
+	for(int level = lowest; level <= SIMD_AVX512; level++)
+	{
+		Parameters::SIMD_LEVEL = level;
+		if(simd_level() != level) break;
+
+		report(std::string("  ") + simd_level_name(simd_level()), best_time(5, f), amount, unit);
+	}
+
+	Parameters::SIMD_LEVEL = saved;
+}
+
+//corner_curvatures() and classify_convexity() over the whole of G, at
+//every level
+static void preprocessing_kernels(Graph& g)
+{
+	g.compute_curvatures();
+
+	const double* positions = &g.get_positions()[0].x;
+	const double* curvatures = &g.get_curvatures()[0].x;
+	int n = g.size(), n_faces = g.n_faces();
+
+	std::vector<int> faces(3 * n_faces);
+	for(int f = 0; f < n_faces; f++)
+	{
+		Face face = g.get_face(f);
+		faces[3*f] = face.a; faces[3*f + 1] = face.b; faces[3*f + 2] = face.c;
+	}
+
+	std::vector<double> corners(9 * n_faces);
+	std::cout<<"  corner_curvatures"<<std::endl;
+	at_each_level(n_faces / 1e6, "Mfaces", [&]() {
+		corner_curvatures(positions, faces.data(), 0, n_faces, corners.data());
+	});
+
+	const double centroid[3] = { 0.0, 0.0, 0.0 };
+	std::vector<Convexity> types(n);
+	std::cout<<"  classify_convexity"<<std::endl;
+	at_each_level(n / 1e6, "Mpoints", [&]() {
+		classify_convexity(positions, curvatures, centroid, 0, n, types.data());
+	});
+}
+
+//------------------------------------------------------
+//-------------------- BENCHMARKS ----------------------
+//------------------------------------------------------
+//The preprocessing kernels on a bumpy 1M-point sphere, single-threaded:
+//as built in memory, and as read back from the MSMS files it's written
+//to (positions rounded to the files' precision, like real input)
+BENCHMARK(simd_kernels)
+{
+	const std::string base = "bench_surface";
+	{
+		Graph g;
+		sphere_surface(1000000, 50.0, g, 0.1, 12);
+		g.build_adjacency();
+
+		std::cout<<"  in memory"<<std::endl;
+		preprocessing_kernels(g);
+		if( !write_msms(g, base) ) { std::cerr<<"Could not write "<<base<<std::endl; return; }
+	}
+	{
+		Graph g;
+		if( FileIO().mesh_from_file(base + ".vert", base + ".face", g) )
+		{
+			std::cout<<"  from "<<base<<".vert/.face"<<std::endl;
+			preprocessing_kernels(g);
+		}
+		else std::cerr<<"Could not load "<<base<<std::endl;
+	}
+	remove( (base + ".vert").c_str() );
+	remove( (base + ".face").c_str() );
+
+	//the polynomial against libm, over [-1, 1]
+	const int N_ACOS = 1000000;
+	std::vector<double> x(N_ACOS);
+	for(int i = 0; i < N_ACOS; i++) x[i] = -1.0 + 2.0 * i / (N_ACOS - 1);
+
+	std::cout<<"  acos"<<std::endl;
+	double t = best_time(5, [&x]() {
+		double sum = 0.0;
+		for(auto v = x.begin(); v != x.end(); ++v) sum += acos(*v);
+		keep(sum);
+	});
+	report("  libm acos", t, N_ACOS / 1e6, "Mcalls");
+
+	t = best_time(5, [&x]() {
+		double sum = 0.0;
+		for(auto v = x.begin(); v != x.end(); ++v) sum += approx_acos(*v);
+		keep(sum);
+	});
+	report("  approx_acos", t, N_ACOS / 1e6, "Mcalls");
+}
+
+//transform_points() on a ligand-sized surface (20k points), one pose
+//at a time and 64 at once, with the exact kernels and the fused ones
+//(there's no fused scalar kernel)
+BENCHMARK(transform_points)
+{
+	Graph g;
+	sphere_surface(20000, 15.0, g, 0.1, 6);
+	const int n = g.size();
+
+	std::vector<glm::dmat4> poses;
+	for(int j = 0; j < 64; j++)
+	{
+		glm::dmat4 T = glm::mat4_cast( glm::angleAxis(0.1 * j, glm::normalize(glm::dvec3(1.0, j, 2.0))) );
+		T[3] = glm::dvec4(j, -j, 0.5 * j, 1.0);
+		poses.push_back(T);
+	}
+
+	std::vector<double> positions(3 * 64 * (size_t)n), normals(3 * 64 * (size_t)n);
+	const int saved = Parameters::FUSED_TRANSFORMS;
+	const int KS[] = { 1, 64 };
+
+	for(int k : KS)
+	{
+		for(int fused = 0; fused <= 1; fused++)
+		{
+			Parameters::FUSED_TRANSFORMS = fused;
+			std::cout<<"  K = "<<k<<(fused ? ", fused" : ", exact")<<std::endl;
+
+			at_each_level(k * (double)n / 1e6, "Mpoints", [&]() {
+				transform_points(&g.get_positions()[0].x, &g.get_normals()[0].x, 0, n,
+								 &poses[0][0][0], k, positions.data(), normals.data());
+				keep(positions[0]);
+			}, fused ? SIMD_AVX2 : SIMD_SCALAR);
+		}
+	}
+
+	Parameters::FUSED_TRANSFORMS = saved;
+}
@@ -0,0 +1,121 @@
+#include "bench.h"
+#include "../inc/util/topk.h"
+#include "../inc/docker/descriptor_index.h"
+#include <vector>
+#include <random>
+#include <string>
+#include <cmath>
+
+//------------------------------------------------------
+//--------------------- INTERNAL -----------------------
+//------------------------------------------------------
+//N descriptors of random convexity and curvature
+static void random_descriptors(int n, std::mt19937& rng, std::vector< std::pair<Patch, Descriptor> >& desc)
+{
+	std::uniform_int_distribution<int> type(0, 2);
+	std::uniform_real_distribution<double> curv(0.01, 2.0);
+
+	for(int i = 0; i < n; i++)
+	{
+		Descriptor d = { curv(rng), (Convexity)type(rng) };
+		desc.push_back( std::make_pair(Patch(glm::dvec3(0.0, 0.0, 1.0), std::vector<int>(1, i)), d) );
+	}
+}
+
+//------------------------------------------------------
+//-------------------- BENCHMARKS ----------------------
+//------------------------------------------------------
+//Top-K of 10k candidates (random distances, a few NaN ones) with the
+//bounded heap, against collecting them all and sorting, as
+//most_complementary() did before
+BENCHMARK(topk)
+{
+	const int N = 10000, QUERIES = 200;
+	const int KS[] = { 1, 10, 100, 1000 };
+
+	std::mt19937 rng(11);
+	std::uniform_real_distribution<double> distance(0.0, 1.0);
+
+	std::vector<Candidate> candidates(N);
+	for(int i = 0; i < N; i++)
+		candidates[i] = std::make_pair(i % 100 == 0 ? std::nan("") : distance(rng), i);
+
+	CandidateOrder order;
+	std::vector<Candidate> all, out;
+	CandidateSelection best;
+
+	for(int k : KS)
+	{
+		std::cout<<"  K = "<<k<<std::endl;
+
+		double t = best_time(3, [&]() {
+			for(int q = 0; q < QUERIES; q++)
+			{
+				all.assign(candidates.begin(), candidates.end());
+				std::sort(all.begin(), all.end(), order);
+				all.resize(k);
+				keep(all[0]);
+			}
+		});
+		report("  full sort", t, QUERIES * (double)N / 1e6, "Mcandidates");
+
+		t = best_time(3, [&]() {
+			for(int q = 0; q < QUERIES; q++)
+			{
+				best.reset(k);
+				for(auto c = candidates.begin(); c != candidates.end(); ++c) best.push(*c);
+				best.sorted(out);
+				keep(out[0]);
+			}
+		});
+		report("  bounded heap", t, QUERIES * (double)N / 1e6, "Mcandidates");
+
+		if(out != all) std::cout<<"  (selections differ!)"<<std::endl;
+	}
+}
+
+//The N_BEST_PAIRS ligand patches of every receptor patch, for a library
+//of ligands as screening sees it: each ligand is indexed, then queried
+//once per receptor patch. Building the index is the part repeated per
+//ligand that indexing the receptor once would save.
+BENCHMARK(complementary_pairs)
+{
+	const int N_RECEPTOR = 10000, N_LIGANDS = 20;
+	const int LIGAND_SIZES[] = { 200, 2000 };
+	const int KS[] = { 5, 50 };
+
+	std::mt19937 rng(12);
+	std::vector< std::pair<Patch, Descriptor> > receptor;
+	random_descriptors(N_RECEPTOR, rng, receptor);
+
+	std::vector<Candidate> list;
+	for(int n : LIGAND_SIZES)
+	{
+		std::vector< std::vector< std::pair<Patch, Descriptor> > > ligands(N_LIGANDS);
+		for(auto l = ligands.begin(); l != ligands.end(); ++l) random_descriptors(n, rng, *l);
+
+		double t = best_time(3, [&]() {
+			for(auto l = ligands.begin(); l != ligands.end(); ++l) { DescriptorIndex index(*l); keep(&index); }
+		});
+		std::cout<<"  "<<n<<" patches per ligand"<<std::endl;
+		report("  building the index", t, N_LIGANDS, "ligands");
+
+		for(int k : KS)
+		{
+			t = best_time(3, [&]() {
+				CandidateSelection best;
+				for(auto l = ligands.begin(); l != ligands.end(); ++l)
+				{
+					DescriptorIndex index(*l);
+					for(auto r = receptor.begin(); r != receptor.end(); ++r)
+					{
+						index.most_complementary(r->second, k, best);
+						best.sorted(list);
+					}
+					keep(list.size());
+				}
+			});
+			report(std::string("  building and querying, K = ") + std::to_string(k), t, N_LIGANDS, "ligands");
+		}
+	}
+}
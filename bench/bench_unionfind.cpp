@@ -0,0 +1,118 @@
+#include "bench.h"
+#include "../inc/util/unionfind.h"
+#include <vector>
+#include <random>
+
+//------------------------------------------------------
+//--------------------- INTERNAL -----------------------
+//------------------------------------------------------
+//The union-find UnionFind replaced: recursive find(), no path
+//compression and no union by size
+class PlainUnionFind
+{
+private:
+	std::vector<int> parent;
+
+public:
+	PlainUnionFind(unsigned int n) : parent(n) { for(unsigned int i = 0; i < n; i++) parent[i] = i; }
+
+	int find(int a) const { return parent[a] == a ? a : find(parent[a]); }
+	void merge(int a, int b) { int pa = find(a), pb = find(b); parent[pb] = pa; }
+
+	void clusters(std::vector< std::vector<int> >& clusters) const
+	{
+		std::vector<int> hash(parent.size(), -1);
+		for(unsigned int i = 0; i < parent.size(); i++)
+		{
+			int s = find(i);
+			if(hash[s] == -1) { hash[s] = clusters.size(); clusters.push_back( std::vector<int>() ); }
+			clusters[ hash[s] ].push_back(i);
+		}
+	}
+};
+
+typedef std::vector< std::pair<int,int> > Merges;
+
+//Merges N/2 random pairs of N elements
+static void random_merges(int n, Merges& merges)
+{
+	std::mt19937 rng(7);
+	std::uniform_int_distribution<int> element(0, n - 1);
+	merges.resize(n / 2);
+	for(auto m = merges.begin(); m != merges.end(); ++m) *m = std::make_pair(element(rng), element(rng));
+}
+
+//Merges every element into the set of the next one, which builds a
+//single chain when no balancing is done
+static void chain_merges(int n, Merges& merges)
+{
+	merges.resize(n - 1);
+	for(int i = 0; i + 1 < n; i++) merges[i] = std::make_pair(i + 1, i);
+}
+
+//Merges, then a find() of every element, then the clusters
+template<typename UF, typename CLUSTERS>
+static void run(const std::string& name, int n, const Merges& merges, int repeats)
+{
+	double t_merge = 0.0, t_find = 0.0, t_clusters = 0.0;
+	for(int r = 0; r < repeats; r++)
+	{
+		UF uf(n);
+		CLUSTERS c;
+
+		double t = best_time(1, [&uf, &merges]() {
+			for(auto m = merges.begin(); m != merges.end(); ++m) uf.merge(m->first, m->second);
+		});
+		double f = best_time(1, [&uf, n]() {
+			long sum = 0;
+			for(int i = 0; i < n; i++) sum += uf.find(i);
+			keep(sum);
+		});
+		double k = best_time(1, [&uf, &c]() { uf.clusters(c); });
+
+		if(r == 0 || t < t_merge) t_merge = t;
+		if(r == 0 || f < t_find) t_find = f;
+		if(r == 0 || k < t_clusters) t_clusters = k;
+	}
+
+	report(name + " merge", t_merge, merges.size() / 1e6, "Mops");
+	report(name + " find", t_find, n / 1e6, "Mops");
+	report(name + " clusters", t_clusters, n / 1e6, "Melements");
+}
+
+//UnionFind::clusters() fills offsets and members
+typedef struct Clusters {
+	std::vector<int> offsets, members;
+} Clusters;
+
+class BalancedUnionFind : public UnionFind
+{
+public:
+	BalancedUnionFind(unsigned int n) : UnionFind(n) { }
+	void clusters(Clusters& c) const { UnionFind::clusters(c.offsets, c.members); }
+};
+
+//------------------------------------------------------
+//-------------------- BENCHMARKS ----------------------
+//------------------------------------------------------
+//Merge/find patterns over 1M elements. The plain union-find goes
+//quadratic on the chain, so it only gets 20k elements there.
+BENCHMARK(unionfind)
+{
+	const int N = 1000000, N_CHAIN_PLAIN = 20000;
+	Merges merges;
+
+	random_merges(N, merges);
+	std::cout<<"  random pairs, "<<N<<" elements"<<std::endl;
+	run< PlainUnionFind, std::vector< std::vector<int> > >("  plain", N, merges, 3);
+	run< BalancedUnionFind, Clusters >("  by size + halving", N, merges, 3);
+
+	chain_merges(N_CHAIN_PLAIN, merges);
+	std::cout<<"  chain, "<<N_CHAIN_PLAIN<<" elements"<<std::endl;
+	run< PlainUnionFind, std::vector< std::vector<int> > >("  plain", N_CHAIN_PLAIN, merges, 1);
+	run< BalancedUnionFind, Clusters >("  by size + halving", N_CHAIN_PLAIN, merges, 3);
+
+	chain_merges(N, merges);
+	std::cout<<"  chain, "<<N<<" elements"<<std::endl;
+	run< BalancedUnionFind, Clusters >("  by size + halving", N, merges, 3);
+}
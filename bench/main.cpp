@@ -0,0 +1,37 @@
+#include "bench.h"
+#include <vector>
+#include <utility>
+#include <cstring>
+
+//------------------------------------------------------
+//--------------------- INTERNAL -----------------------
+//------------------------------------------------------
+static std::vector< std::pair<const char*, BenchFunction> >& registry()
+{
+	static std::vector< std::pair<const char*, BenchFunction> > benchmarks;
+	return benchmarks;
+}
+
+//------------------------------------------------------
+//-------------------- FROM BENCH.H --------------------
+//------------------------------------------------------
+BenchRegistrar::BenchRegistrar(const char* name, BenchFunction f)
+{
+	registry().push_back( std::make_pair(name, f) );
+}
+
+//	run_bench [FILTER]
+int main(int argc, char** args)
+{
+	const char* filter = argc > 1 ? args[1] : "";
+
+	for(auto b = registry().begin(); b != registry().end(); ++b)
+	{
+		if( !strstr(b->first, filter) ) continue;
+
+		std::cout<<b->first<<std::endl;
+		b->second();
+	}
+
+	return 0;
+}
@@ -0,0 +1,65 @@
+#ifndef _DESCRIPTOR_INDEX_H_
+#define _DESCRIPTOR_INDEX_H_
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cmath>
+#include "../descriptor/descriptor.h"
+#include "../graph/convexity.h"
+#include "../graph/patch.h"
+#include "../util/topk.h"
+
+//Dissimilarity between the curvatures of two patches: their relative
+//difference. Smaller means more complementary (if convexities differ).
+inline double curvature_distance(double lhs, double rhs)
+{
+	return fabs(lhs - rhs) / std::max(lhs, rhs);
+}
+
+//A candidate patch for a query: (curvature_distance, patch index)
+typedef std::pair<double, int> Candidate;
+
+//Orders candidates by distance and then by index, with NaN distances
+//(from degenerate patches) last: they're only picked if there's
+//nothing else.
+struct CandidateOrder
+{
+	bool operator()(const Candidate& lhs, const Candidate& rhs) const
+	{
+		bool lnan = std::isnan(lhs.first), rnan = std::isnan(rhs.first);
+		if(lnan != rnan) return rnan;
+		if(!lnan && lhs.first != rhs.first) return lhs.first < rhs.first;
+		return lhs.second < rhs.second;
+	}
+};
+
+typedef TopK<Candidate, CandidateOrder> CandidateSelection;
+
+// Index over the descriptors of a surface which answers "the K patches
+// most complementary to this descriptor" without looking at all of them.
+// Patches of each convexity are kept sorted by curvature. For positive
+// curvatures the distance to a query only grows as we walk away from the
+// query's position in a list, so we walk outwards from it on both sides
+// (a binary search, then K steps or so). Lists with curvatures that are
+// not positive (degenerate patches) are scanned entirely instead.
+class DescriptorIndex
+{
+private:
+	typedef std::pair<double, int> Entry;	//(curvature, patch index)
+
+	std::vector<Entry> by_type[3];			//indexed by Convexity
+	bool all_positive[3];					//every curvature in the list is > 0
+
+public:
+	explicit DescriptorIndex(const std::vector< std::pair<Patch, Descriptor> >& desc);
+
+	//Selects into BEST the K patches of a convexity other than D's with
+	//the least curvature_distance to D (in CandidateOrder). BEST is reset
+	//first; it holds fewer than K if there are not that many patches of
+	//another convexity. Callers keep BEST across queries to reuse its
+	//storage.
+	void most_complementary(const Descriptor& d, int k, CandidateSelection& best) const;
+};
+
+#endif
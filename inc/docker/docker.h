@@ -6,29 +6,43 @@
 #include "../descriptor/descriptor.h"
 #include "../graph/patch.h"
 #include "../graph/graph.h"
+#include "./descriptor_index.h"
 
 typedef std::vector<std::pair<int,int> > 			MatchingGroup;
 typedef std::vector<std::pair<Patch, Descriptor> >	SurfaceDescriptors;
 
+//Docker holds no state: every call only reads its arguments, so
+//independent docking jobs can each use their own (or share one).
 class Docker
 {
-private:
-	static Docker* docker_ptr;
-
 public:
-	static Docker* instance() {
-		if(!Docker::docker_ptr)
-			Docker::docker_ptr = new Docker();
-		return Docker::docker_ptr;
-	}
-
 	//------------------------------
 	//------ Main operations -------
 	//------------------------------
-	void build_matching_groups(const SurfaceDescriptors& desc_target,
-								const SurfaceDescriptors& desc_ligand,
+	//Grouping measures geodesic distances on the surfaces, so
+	//both must have been through Graph::preprocess_mesh(), with
+	//geodesics reaching at least Parameters::G_THRESH. Returns false
+	//(and adds no group) if they weren't.
+	bool build_matching_groups(const Graph& target, const SurfaceDescriptors& desc_target,
+								const Graph& ligand, const SurfaceDescriptors& desc_ligand,
+								std::vector<MatchingGroup>& groups_out) const;
+
+	//Same, with an index over the ligand descriptors built by the caller.
+	//Pairs are selected per target patch (its K most complementary ligand
+	//patches, as a full sort orders them), so the index is over the
+	//ligand: building it is a sort of the ligand patches, a small part of
+	//querying it once per target patch (see the complementary_pairs
+	//benchmark). An index over the receptor answers per ligand patch;
+	//turning that into the same per-target selections, by offering every
+	//ligand patch to the target patches near it, was 3 to 6 times slower.
+	bool build_matching_groups(const Graph& target, const SurfaceDescriptors& desc_target,
+								const Graph& ligand, const SurfaceDescriptors& desc_ligand,
+								const DescriptorIndex& ligand_index,
 								std::vector<MatchingGroup>& groups_out) const;
 
+	//Appends to MG_TRANSFORMATION the rigid transformation of LIGAND
+	//onto TARGET for every matching group, in order (see align_group()
+	//in docker.cpp). Groups are aligned in parallel.
 	void transformations_from_matching_groups(const std::vector<MatchingGroup>& matching_groups, 
 												const Graph& target, const SurfaceDescriptors& desc_target,
 												const Graph& ligand, const SurfaceDescriptors& desc_ligand,
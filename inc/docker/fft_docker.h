@@ -0,0 +1,64 @@
+#ifndef _FFT_DOCKER_H_
+#define _FFT_DOCKER_H_
+
+#include <vector>
+#include <complex>
+#include <glm/glm.hpp>
+#include "./scoring.h"
+#include "../math/fft.h"
+#include "../graph/graph.h"
+
+//A pose found by the exhaustive search
+typedef struct {
+	glm::dmat4 transform;	//aligns the ligand to the receptor
+	double correlation;		//shape complementarity on the FFT grids
+	int rotation;			//index of the rotation in the rotation set
+	PoseScore score;		//the same pose, scored by Scoring
+} FFTPose;
+
+// Exhaustive rigid docking in the style of Katchalski-Katzir: for every
+// rotation of a set of Parameters::FFT_ROTATIONS (nearly uniform) ones,
+// all the translations of the ligand on a grid are scored at once as a
+// correlation computed with FFTs. It does not depend on patches or
+// matching groups at all, so it is a baseline to compare them with.
+//
+// Both surfaces are discretised every Parameters::FFT_SPACING. Receptor
+// nodes within CONTACT_DIST outside or CLASH_DEPTH inside the surface
+// (the surface layer) are worth 1, deeper nodes -CLASH_PENALTY and
+// outside nodes 0; ligand nodes are 1 inside the ligand and 0 outside.
+// The correlation of a pose is then the overlap of the ligand with the
+// surface layer, minus the penalty of its overlap with the interior,
+// like Scoring but on the volume of the ligand.
+//
+// The receptor grid is transformed once, and the FFT plan is shared by
+// every rotation; rotations run in parallel.
+class FFTDocker
+{
+private:
+	const Graph& receptor;
+	const Scoring& scoring;		//its grid discretises the receptor, and it scores the poses
+
+public:
+	FFTDocker(const Graph& receptor, const Scoring& scoring);
+
+	//Keeps the best Parameters::N_BEST_POSES poses of LIGAND, by
+	//correlation (best first). Each rotation contributes at most its
+	//few best translations.
+	void dock(const Graph& ligand, std::vector<FFTPose>& poses) const;
+
+	//N rotations spread (almost) uniformly over SO(3), from a
+	//super-Fibonacci spiral of unit quaternions
+	static void rotation_set(int n, std::vector<glm::dmat3>& rotations);
+
+	//Correlations of the receptor with the ligand rotated by each of
+	//ROTATIONS[0 .. COUNT-1] (COUNT is 1 or 2) about CENTER, for every
+	//translation on the grid of PLAN. REC is the receptor grid, already
+	//transformed; LIGAND_GRID samples the ligand, out to REACH nodes from
+	//its centre. LIG is left holding the first correlation as its real
+	//part and minus the second as its imaginary part.
+	static void correlate(const FFTPlan& plan, const std::vector< std::complex<double> >& rec,
+						  const ReceptorGrid& ligand_grid, const glm::dvec3& center, int reach,
+						  const glm::dmat3* rotations, int count, std::vector< std::complex<double> >& lig);
+};
+
+#endif
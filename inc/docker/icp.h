@@ -0,0 +1,53 @@
+#ifndef _ICP_H_
+#define _ICP_H_
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "./docker.h"
+#include "../graph/graph.h"
+#include "../util/kd_tree.h"
+
+//Outcome of refining one pose
+typedef struct {
+	glm::dmat4 transform;	//refined transformation
+	int iterations;			//iterations run
+	bool converged;			//whether the last update was below Parameters::ICP_TOLERANCE
+	int pairs;				//point pairs matched in the last iteration
+	double rms;				//point-to-plane RMS distance of those pairs
+	double seconds;			//wall-clock time spent on this pose
+} ICPResult;
+
+// Refines coarse ligand poses with point-to-plane ICP (Chen & Medioni)
+// against one target surface. At every iteration each point of the
+// ligand cloud, moved by the current pose, is paired with its nearest
+// target point within Parameters::ICP_MAX_DIST, if their normals face
+// each other, and the pose is updated by the small rigid motion which
+// best brings the ligand points onto the tangent planes of their pairs
+// (the MSMS normals of the target). That linear least-squares problem
+// is 6x6, solved on the stack; motions the pairs leave unconstrained
+// (e.g. sliding over a spherical cap) are not applied.
+//
+// Nearest points are found through a k-d tree of the target, built once
+// and shared (read-only) by every pose.
+class ICP
+{
+private:
+	const Graph& target;
+	KDTree tree;
+
+public:
+	explicit ICP(const Graph& target);
+
+	//Refines START, aligning the NODES of LIGAND (as loaded: its pose is ignored)
+	ICPResult refine(const Graph& ligand, const std::vector<int>& nodes, const glm::dmat4& start) const;
+
+	//Refines the transformation of every matching group in place, in
+	//parallel. The ligand cloud of a group is the nodes of its ligand
+	//patches; RESULTS[i] reports on TRANSFORMATIONS[i].
+	void refine_groups(const std::vector<MatchingGroup>& groups,
+					   const Graph& ligand, const SurfaceDescriptors& desc_ligand,
+					   std::vector<glm::dmat4>& transformations,
+					   std::vector<ICPResult>& results) const;
+};
+
+#endif
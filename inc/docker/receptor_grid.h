@@ -0,0 +1,78 @@
+#ifndef _RECEPTOR_GRID_H_
+#define _RECEPTOR_GRID_H_
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "../graph/graph.h"
+#include "../io/mapped_file.h"
+
+//Trilinear sample of the receptor grids at a point
+typedef struct {
+	float distance;		//signed distance to the surface, negative inside
+	float occupancy;	//share of the receptor around the point: 1 inside, 0 outside
+	glm::vec3 normal;	//normal of the nearest surface point; 0 far from the surface
+} GridSample;
+
+// A receptor surface sampled on a regular grid around it, so that what
+// scoring needs to know about any point in space (how far it is from
+// the surface, whether it is inside, which way the surface faces) is a
+// few memory accesses, whatever the size of the receptor. Three grids
+// are kept: the signed distance to the surface (exact within BAND of it,
+// clamped to +-BAND farther away), the occupancy (1 inside, 0 outside)
+// and the normal at the nearest surface point (within BAND). Points are
+// sampled with trilinear interpolation.
+//
+// The grids are stored in a single block, which is also the payload of
+// the grid cache file: a grid loaded from a cache is used straight from
+// the mapped file.
+class ReceptorGrid
+{
+private:
+	glm::dvec3 origin;			//position of node (0,0,0)
+	double spacing;				//distance between neighbouring nodes
+	double band;
+	int dims[3];
+	uint64_t source;			//hash of the receptor the grids were built from
+
+	//node (i,j,k) is at n = i + dims[0]*(j + dims[1]*k): its distance
+	//at distance[n], its occupancy at occupancy[n] and its normal at
+	//normals[3n .. 3n+2]. They point into STORAGE if the grids were
+	//built, into FILE if they were loaded.
+	const float *distance, *occupancy, *normals;
+	std::vector<float> storage;
+	MappedFile file;
+
+	size_t n_nodes() const { return (size_t)dims[0] * dims[1] * dims[2]; }
+	void clear();
+
+	ReceptorGrid(const ReceptorGrid&) = delete;
+	ReceptorGrid& operator=(const ReceptorGrid&) = delete;
+
+public:
+	ReceptorGrid();
+
+	//Samples the surface of RECEPTOR every SPACING, computing distances
+	//and normals up to BAND from it. Which side of the surface a node
+	//near it is on is given by the normal at its nearest surface point;
+	//nodes farther away are outside if they can be reached from the
+	//border of the grid without getting within BAND of the surface.
+	void build(const Graph& receptor, double spacing, double band);
+
+	//Grid cache files. load() maps the file and only accepts it if it
+	//was built from the same receptor (same positions and normals) with
+	//the same SPACING and BAND, and its checksum matches.
+	bool save(const std::string& path) const;
+	bool load(const std::string& path, const Graph& receptor, double spacing, double band);
+
+	bool empty() const { return n_nodes() == 0; }
+	double get_spacing() const { return spacing; }
+	double get_band() const { return band; }
+
+	//Trilinear sample at P. Outside the grid, everything is far outside
+	//the receptor: distance BAND, occupancy and normal 0.
+	GridSample sample(const glm::dvec3& p) const;
+};
+
+#endif
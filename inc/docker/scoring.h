@@ -0,0 +1,49 @@
+#ifndef _SCORING_H_
+#define _SCORING_H_
+
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "./receptor_grid.h"
+#include "../graph/graph.h"
+
+//Score of a ligand pose (a transformation of the ligand surface)
+typedef struct {
+	int pose;		//index of the transformation
+	double score;	//contacts - CLASH_PENALTY * clashes; higher is better
+	int contacts;	//ligand points near the receptor surface
+	int clashes;	//ligand points deep inside the receptor
+} PoseScore;
+
+// Rigid-body scoring of ligand poses against one receptor. A ligand
+// point is in contact if it lies within CONTACT_DIST outside of the
+// receptor surface or CLASH_DEPTH inside of it, with the two surfaces
+// facing each other (opposite normals), and clashes if it is inside
+// the receptor deeper than that. The receptor is only looked at through
+// its ReceptorGrid, built once (or loaded from a cache); scoring a pose
+// transforms each ligand point on the fly and samples the grid there,
+// so it is linear in the size of the ligand and the transformed ligand
+// is never stored.
+class Scoring
+{
+private:
+	ReceptorGrid grid;
+
+public:
+	//Samples RECEPTOR every Parameters::GRID_SPACING. If GRID_CACHE
+	//is given, the grid is loaded from it if valid, or built and
+	//written to it otherwise.
+	explicit Scoring(const Graph& receptor, const std::string& grid_cache = std::string());
+
+	const ReceptorGrid& get_grid() const { return grid; }
+
+	//Scores LIGAND (as loaded: its pose is ignored) transformed by T
+	PoseScore score(const Graph& ligand, const glm::dmat4& T) const;
+
+	//Scores LIGAND under every transformation in POSES, in parallel.
+	//RANKED is sorted best first (ties keep the order of POSES).
+	void rank(const Graph& ligand, const std::vector<glm::dmat4>& poses,
+			  std::vector<PoseScore>& ranked) const;
+};
+
+#endif
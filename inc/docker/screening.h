@@ -0,0 +1,58 @@
+#ifndef _SCREENING_H_
+#define _SCREENING_H_
+
+#include <string>
+#include <vector>
+#include "./docker.h"
+#include "./scoring.h"
+#include "./icp.h"
+#include "../graph/graph.h"
+
+//Outcome of docking one ligand of a library against the receptor
+typedef struct {
+	std::string ligand;		//basename of the ligand surface
+	bool ok;				//false if the ligand couldn't be loaded or grouped, or its results written
+	int n_patches;			//patches found on the ligand surface
+	int n_groups;			//matching groups (and so transformations) found
+	double best_score;		//score of the best pose (0 if there are none)
+	double seconds;			//wall-clock time spent on this ligand
+} ScreeningResult;
+
+//Screens a library of ligands against a single receptor. The receptor
+//is loaded and preprocessed by the caller, once; the screening only
+//reads it, so its surface and descriptors are shared by all ligands.
+//Each ligand goes through the same pipeline as a single docking run
+//(preprocessing, matching groups, transformations, ICP refinement,
+//scoring), and its results
+//are written to a file of its own: the Parameters::N_BEST_POSES best
+//scoring transformations, best first.
+class Screening
+{
+private:
+	const Graph& receptor;
+	const SurfaceDescriptors& desc_receptor;
+	Scoring scoring;		//built from the receptor once, shared by all ligands
+	ICP icp;				//same
+
+public:
+	//GRID_CACHE is the cache file of the receptor scoring grid (see Scoring)
+	Screening(const Graph& receptor, const SurfaceDescriptors& desc_receptor,
+			  const std::string& grid_cache = std::string());
+
+	//Reads the manifest: one ligand basename per line (the surface is
+	//BASENAME.vert/BASENAME.face); blank lines and lines starting with
+	//'#' are skipped. Returns false if the file could not be read.
+	static bool read_manifest(const std::string& path, std::vector<std::string>& ligands);
+
+	//Docks the ligand BASENAME and writes its results to OUT_PATH.
+	ScreeningResult dock_ligand(const std::string& basename, const std::string& out_path) const;
+
+	//Docks every ligand in LIGANDS, writing the results of BASENAME
+	//to OUTDIR/<file name of BASENAME>.dock (OUTDIR is created if needed).
+	//Ligands run in parallel on a ThreadPool of Parameters::N_THREADS
+	//workers; RESULTS keeps the order of LIGANDS.
+	void run(const std::vector<std::string>& ligands, const std::string& outdir,
+			 std::vector<ScreeningResult>& results) const;
+};
+
+#endif
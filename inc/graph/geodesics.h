@@ -0,0 +1,50 @@
+#ifndef _GEODESICS_H_
+#define _GEODESICS_H_
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include "../util/flat_array.h"
+
+// Geodesic distances between the patches of a surface: the lengths of
+// the shortest paths along mesh edges between their seeds. Distances
+// are only computed up to a cutoff (grouping never needs more); pairs
+// farther than that, or on different components of the mesh, are at
+// +infinity. The matrix is symmetric with a zero diagonal, so only its
+// strict upper triangle is kept, and only its finite entries: row i
+// holds the patches j > i within the cutoff, sorted, with their
+// distance in single precision (compressed-sparse-row form). A dense
+// triangle would need n²/2 floats whatever the cutoff. Loaded from a
+// cache, the arrays are views of the cache file (see FlatArray).
+class PatchGeodesics
+{
+	//Graph computes the distances, the binary cache stores them
+	friend class Graph;
+	friend class FileIO;
+
+private:
+	double cutoff;
+	FlatArray<int> row_offsets;		//row i is [ row_offsets[i], row_offsets[i+1] )
+	FlatArray<int> cols;
+	FlatArray<float> dists;
+
+public:
+	PatchGeodesics() : cutoff(0.0) { }
+
+	int size() const { return row_offsets.empty() ? 0 : row_offsets.size() - 1; }
+	double get_cutoff() const { return cutoff; }
+
+	float distance(int i, int j) const
+	{
+		if(i == j) return 0.0f;
+		if(i > j) std::swap(i, j);
+
+		auto first = cols.begin() + row_offsets[i], last = cols.begin() + row_offsets[i+1];
+		auto it = std::lower_bound(first, last, j);
+
+		if(it == last || *it != j) return std::numeric_limits<float>::infinity();
+		return dists[ it - cols.begin() ];
+	}
+};
+
+#endif
@@ -3,9 +3,15 @@
 
 #include <vector>
 #include <utility>
-#include "node.h"
+#include <string>
+#include <glm/glm.hpp>
+#include "convexity.h"
 #include "patch.h"
+#include "geodesics.h"
 #include "../util/unionfind.h"
+#include "../util/span.h"
+#include "../util/flat_array.h"
+#include "../io/mapped_file.h"
 
 typedef struct {
 	int a, b, c;
@@ -13,30 +19,92 @@ typedef struct {
 
 class Graph
 {
+	//The binary cache reads and writes the storage directly
+	friend class FileIO;
+
 private:
-	//Here we store the original position of the nodes,
-	//so we can apply multiple transformations. We copy
-	//the contents from this->nodes in the first call to
-	//transform_cloud().
-	std::vector<Node> original_nodes;
+	//Node attributes are stored as parallel arrays (one entry per
+	//node), so each pass only streams the attributes it needs. These,
+	//the faces and the adjacency are FlatArrays: a surface loaded from
+	//a cache views them in FILE, which lives as long as the graph.
+	FlatArray<glm::dvec3> positions, normals, curvatures;
+	FlatArray<Convexity> types;
+	MappedFile file;
+
+	glm::vec3 color = glm::vec3(1.0f, 1.0f, 1.0f); //useful for rendering only
+
+	//Rigid transformation the surface is posed with. Positions and
+	//normals above are never changed by it: the posed ones are read
+	//through a TransformedView, so a pose costs nothing until it's used.
+	glm::dmat4 pose = glm::dmat4(1.0);
+
+	FlatArray<Face> faces;
 
-	std::vector<Node> nodes;
-	std::vector<Face> faces; //Used for rendering only (so far)
+	//Adjacency in compressed-sparse-row form, built from the face
+	//list by build_adjacency() once loading is over. The faces incident
+	//to node i are stored as the pairs of the other two vertices in
+	//adj_faces[ adj_offsets[i] .. adj_offsets[i+1] ), in face order.
+	//adj_corners holds, for each of these entries, 3*f + k if node i
+	//is corner k (a, b, c) of face f.
+	//The distinct neighbours of node i (in order of first appearance in
+	//its incident faces) are in ngbr[ ngbr_offsets[i] .. ngbr_offsets[i+1] ).
+	FlatArray<int> adj_offsets;
+	FlatArray< std::pair<int,int> > adj_faces;
+	FlatArray<int> adj_corners;
+	FlatArray<int> ngbr_offsets;
+	FlatArray<int> ngbr;
+
+	void build_neighbours();
+
+	//Distances between the patches found by preprocess_mesh()
+	PatchGeodesics patch_geodesics;
+
+	Graph(const Graph&) = delete;
+	Graph& operator=(const Graph&) = delete;
 
 public:
+	Graph() { }
 
 	//---------------------------------
 	//--------- Access method ---------
 	//---------------------------------
-	unsigned int size() const { return nodes.size(); }
+	unsigned int size() const { return positions.size(); }
 	unsigned int n_faces() const { return faces.size(); }
 
+	void reserve_nodes(unsigned int n);
+	void reserve_faces(unsigned int n) { faces.own().reserve(n); }
+
+	//push_face() only records the face: the adjacency is built
+	//all at once by build_adjacency() after the last face is pushed
 	void push_node(double x, double y, double z, double nx, double ny, double nz);
 	void push_face(int a, int b, int c);
+	void build_adjacency();
+	bool has_adjacency() const { return adj_offsets.size() == positions.size() + 1; }
 
-	Node get_node(int i) const
+	//Position and normal of node I as loaded (unposed): the pose set by
+	//transform_cloud() is only applied through a TransformedView
+	const glm::dvec3& get_pos(int i) const { return positions[i]; }
+	const glm::dvec3& get_normal(int i) const { return normals[i]; }
+	const glm::dvec3& get_curvature(int i) const { return curvatures[i]; }
+	Convexity get_type(int i) const { return types[i]; }
+	const glm::vec3& get_color(int) const { return color; }
+
+	//whole attribute arrays, indexed by node (unposed, like get_pos())
+	ConstSpan<glm::dvec3> get_positions() const { return positions; }
+	ConstSpan<glm::dvec3> get_normals() const { return normals; }
+	ConstSpan<glm::dvec3> get_curvatures() const { return curvatures; }
+	ConstSpan<Convexity> get_types() const { return types; }
+
+	ConstSpan< std::pair<int,int> > incident_faces(int i) const
+	{
+		const std::pair<int,int>* base = adj_faces.data();
+		return ConstSpan< std::pair<int,int> >(base + adj_offsets[i], base + adj_offsets[i+1]);
+	}
+
+	ConstSpan<int> neighbours(int i) const
 	{
-		return nodes[i];
+		const int* base = ngbr.data();
+		return ConstSpan<int>(base + ngbr_offsets[i], base + ngbr_offsets[i+1]);
 	}
 
 	Face get_face(int i) const
@@ -44,6 +112,12 @@ public:
 		return faces[i];
 	}
 
+	const PatchGeodesics& get_patch_geodesics() const { return patch_geodesics; }
+
+	//Positions and normals are those of the surface as loaded; this
+	//is the pose set by transform_cloud()
+	const glm::dmat4& get_pose() const { return pose; }
+
 	//-------------------------------
 	//--------- Operations ----------
 	//-------------------------------
@@ -53,6 +127,12 @@ public:
 	void classify_points();
 	void segment_by_curvature(UnionFind& uf);
 	void feature_points(const UnionFind& uf, std::vector<Patch>& feature);
+
+	//Hop distance of every node to the contour of its region (the regions
+	//being the clusters of UF), as feature_points() ranks them: -1 for the
+	//nodes which can't reach it
+	void contour_distances(const UnionFind& uf, std::vector<int>& dist) const;
+	void compute_patch_geodesics(const std::vector<Patch>& patches, double cutoff);
 	void transform_cloud(const glm::dmat4& T);
 	void set_base_color(const glm::vec3& color);
 
@@ -3,11 +3,15 @@
 
 #include <vector>
 #include <glm/glm.hpp>
-#include "./node.h"
+#include "./convexity.h"
 #include "../descriptor/descriptor.h"
+#include "../util/span.h"
 
 class Patch
 {
+	//The binary cache reads and writes the storage directly
+	friend class FileIO;
+
 private:
 	glm::dvec3 normal, centroid, curvature;
 public:
@@ -21,17 +25,20 @@ public:
 	//-----------------------------------
 	int patch_size() const { return nodes.size(); }
 
+	//the point the patch was grown from
+	int get_seed() const { return nodes[0]; }
+
 	//-----------------------------------
 	//----------- OPERATIONS ------------
 	//-----------------------------------
-	Descriptor compute_descriptor(const std::vector<Node>& points);
+	Descriptor compute_descriptor(ConstSpan<glm::dvec3> positions);
 	glm::dvec3 get_pos() const;
 	glm::dvec3 get_normal() const;
 	glm::dvec3 get_curvature() const;
 
 	void set_curvature(const glm::dvec3& c);
 
-	void paint_patch(std::vector<Node>& graph, const glm::vec3& color) const;
+	void paint_patch(std::vector<glm::vec3>& colors, const glm::vec3& color) const;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,64 @@
+#ifndef _TRANSFORMED_VIEW_H_
+#define _TRANSFORMED_VIEW_H_
+
+#include <glm/glm.hpp>
+#include "graph.h"
+#include "../math/simd_kernels.h"
+
+// Read-only view of the nodes of a Graph under a rigid transformation.
+// Positions and normals are transformed when they're read, so a pose
+// costs only the nodes actually looked at and nothing is copied: any
+// number of views (poses) of the same surface can be read at once, from
+// any number of threads.
+class TransformedView
+{
+private:
+	const Graph& graph;
+	glm::dmat4 T;
+	glm::dvec3 c0, c1, c2, t;	//columns of the rotation, and the translation
+
+public:
+	TransformedView(const Graph& graph, const glm::dmat4& T)
+		: graph(graph), T(T), c0(T[0]), c1(T[1]), c2(T[2]), t(T[3]) { }
+
+	//The graph under its current pose (see Graph::transform_cloud())
+	explicit TransformedView(const Graph& graph) : TransformedView(graph, graph.get_pose()) { }
+
+	unsigned int size() const { return graph.size(); }
+	const Graph& get_graph() const { return graph; }
+
+	glm::dvec3 get_pos(int i) const
+	{
+		const glm::dvec3& p = graph.get_pos(i);
+		return c0*p.x + c1*p.y + c2*p.z + t;
+	}
+
+	glm::dvec3 get_normal(int i) const
+	{
+		const glm::dvec3& n = graph.get_normal(i);
+		return c0*n.x + c1*n.y + c2*n.z;
+	}
+
+	//Transforms nodes [BEGIN, END) into POSITIONS and NORMALS, which
+	//must hold END - BEGIN elements: scratch buffers the caller reuses
+	//across poses. Either one may be NULL if it's not needed.
+	void transform(int begin, int end, glm::dvec3* positions, glm::dvec3* normals) const
+	{
+		transform_poses(graph, &T, 1, begin, end, positions, normals);
+	}
+
+	//Same, with each of the K POSES in a single pass over the nodes
+	//(see transform_points()): node i under pose j goes to index
+	//j*(END - BEGIN) + (i - BEGIN) of POSITIONS and NORMALS
+	static void transform_poses(const Graph& graph, const glm::dmat4* poses, int k,
+								int begin, int end, glm::dvec3* positions, glm::dvec3* normals)
+	{
+		if(begin >= end || k <= 0) return;
+
+		transform_points(&graph.get_positions()[0].x, &graph.get_normals()[0].x, begin, end,
+						 &poses[0][0][0], k,
+						 positions ? &positions[0].x : NULL, normals ? &normals[0].x : NULL);
+	}
+};
+
+#endif
@@ -2,21 +2,55 @@
 #define _FILEIO_H_
 
 #include <string>
+#include <vector>
+#include <utility>
+#include <cstddef>
 #include "../graph/graph.h"
+#include "../graph/patch.h"
+#include "../descriptor/descriptor.h"
 
+//Filled by mesh_from_file() when requested, so callers
+//can report loading throughput
+typedef struct {
+	size_t bytes;		//total size of the files read
+	double seconds;		//wall-clock time spent reading them
+	bool from_cache;	//whether the surface came from a binary cache
+} LoadStats;
+
+//FileIO holds no state, so independent jobs (e.g. ligands being
+//screened on different threads) can each use their own instance.
 class FileIO
 {
-private:
-	static FileIO* ptr_instance;
-	FileIO();
 public:
-	static FileIO* instance() {
-		if(!FileIO::ptr_instance)
-			FileIO::ptr_instance = new FileIO();
-		return FileIO::ptr_instance;
-	}
+	FileIO();
+
+	//Parses a pair of MSMS .vert/.face files into G. Returns false
+	//if any of the files could not be read.
+	bool mesh_from_file(const std::string& vert, const std::string& face, Graph& g, LoadStats* stats = NULL);
+
+	//------------------------------------
+	//-------- Preprocessed cache --------
+	//------------------------------------
+	//A cache file stores a preprocessed surface (the mesh, per-node
+	//curvature and convexity, and the patches with their descriptors)
+	//in a versioned binary format, so Graph::preprocess_mesh() doesn't
+	//have to run again for a surface we've already seen. The cache
+	//remembers the size and modification time of the .vert/.face files
+	//it was built from and the preprocessing parameters; if any of
+	//them changed, or the checksum doesn't match, the cache is rejected.
+	//A loaded graph uses the arrays of the file in place (keeping it
+	//mapped), so loading costs about one read of the file.
+	bool save_cache(const std::string& path, const std::string& vert, const std::string& face,
+					const Graph& g, const std::vector< std::pair<Patch, Descriptor> >& desc);
+
+	bool load_cache(const std::string& path, const std::string& vert, const std::string& face,
+					Graph& g, std::vector< std::pair<Patch, Descriptor> >& desc, LoadStats* stats = NULL);
 
-	void mesh_from_file(std::string vert, std::string face, Graph& g);
+	//Loads the surface BASENAME.vert/BASENAME.face already preprocessed,
+	//using BASENAME.spdc as a cache: if it is valid we read it, otherwise
+	//we parse the mesh, preprocess it and (re)write the cache.
+	bool surface_from_file(const std::string& basename, Graph& g,
+							std::vector< std::pair<Patch, Descriptor> >& desc, LoadStats* stats = NULL);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,46 @@
+#ifndef _MAPPED_FILE_H_
+#define _MAPPED_FILE_H_
+
+#include <string>
+#include <cstddef>
+#include <utility>
+
+//Read-only memory mapping of a whole file. The contents
+//are accessed in place through [begin(), end()), so parsers
+//built on top of it don't need to copy or allocate anything.
+//The mapping is released when the object is destroyed.
+class MappedFile
+{
+private:
+	const char* data;
+	size_t length;
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+public:
+	MappedFile();
+	~MappedFile();
+
+	//returns false if the file could not be opened or mapped
+	bool open(const std::string& path);
+	void close();
+
+	//Exchanges the mappings of the two objects: the mapped memory
+	//itself doesn't move, so pointers into it stay valid
+	void swap(MappedFile& other)
+	{
+		std::swap(this->data, other.data);
+		std::swap(this->length, other.length);
+	}
+
+	//-----------------------------------
+	//--------- Access methods ----------
+	//-----------------------------------
+	bool is_open() const { return this->data != NULL; }
+	const char* begin() const { return this->data; }
+	const char* end() const { return this->data + this->length; }
+	size_t size() const { return this->length; }
+};
+
+#endif
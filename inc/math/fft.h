@@ -0,0 +1,45 @@
+#ifndef _FFT_H_
+#define _FFT_H_
+
+#include <vector>
+#include <complex>
+
+// Plan for in-place complex FFTs of a cubic n x n x n grid, where n has
+// no prime factors other than 2, 3 and 5 (mixed-radix Cooley-Tukey,
+// decimation in time). The factorisation and the twiddle factors are
+// computed once, when the plan is made; a plan is never modified
+// afterwards, so one plan serves any number of transforms, from any
+// number of threads at once.
+//
+// Grids are stored x fastest: node (x,y,z) is at x + n*(y + n*z).
+class FFTPlan
+{
+private:
+	int n;
+	std::vector<int> factors;						//radixes, in the order they're applied
+	std::vector< std::complex<double> > twiddles;	//exp(-2*pi*i*k/n), k < n
+	std::vector< std::complex<double> > inverse_twiddles;	//and their conjugates
+
+	//DFT of the N values at IN, IN + STRIDE, ..., written contiguously to OUT
+	void transform_step(std::complex<double>* out, const std::complex<double>* in,
+						int n, int stride, int level, bool inverse) const;
+	void transform_line(std::complex<double>* line, std::complex<double>* scratch, bool inverse) const;
+	void transform(std::complex<double>* grid, bool inverse) const;
+
+public:
+	//N must be a product of 2s, 3s and 5s (see next_fft_size())
+	explicit FFTPlan(int n);
+
+	int size() const { return n; }
+
+	//Forward transform: X(k) = sum over x of x(x) * exp(-2*pi*i*<k,x>/n)
+	void forward(std::complex<double>* grid) const;
+
+	//Inverse transform, scaled by 1/n³: inverse(forward(g)) == g
+	void inverse(std::complex<double>* grid) const;
+};
+
+//Smallest size >= N a plan can be made for
+int next_fft_size(int n);
+
+#endif
@@ -1,14 +1,85 @@
 #ifndef _LIN_ALG_H_
-#define _LIN_ALG_G_
+#define _LIN_ALG_H_
 
 #include <glm/glm.hpp>
 #include <cmath>
 #include <vector>
+#include "../util/span.h"
 
 const double EPS = 0.0000001f;
 #define d_equals(a,b) (fabs(a-b) <= EPS ? true : false)
 
 glm::dvec3 triangle_centroid(const glm::dvec3& p1, const glm::dvec3& p2, const glm::dvec3& p3);
-glm::dvec3 cloud_centroid(const std::vector<glm::dvec3>& cloud);
+glm::dvec3 cloud_centroid(ConstSpan<glm::dvec3> cloud);
+
+//Rotation R which maximises sum( (R a_i) . b_i ) over pairs of vectors
+//(a_i, b_i), given their correlation M = sum( a_i b_i^T ), i.e.
+//M[j][k] = sum( a_i[j] * b_i[k] ). Horn's closed form: the unit
+//quaternion of R is the leading eigenvector of a 4x4 matrix built from
+//M, so R is always a proper rotation (never a reflection, never
+//scaled). Any rotation is as good if M is zero.
+glm::dmat3 optimal_rotation(const double m[3][3]);
+
+//Eigen-decomposition of the symmetric NxN matrix A with cyclic Jacobi
+//rotations. A is destroyed. EVAL[i] is the i-th eigenvalue (unsorted)
+//and column i of EVEC its unit eigenvector. Meant for the tiny matrices
+//of PCA and alignment: it works in place and never allocates.
+template<int N>
+void symmetric_eigen(double a[N][N], double eval[N], double evec[N][N])
+{
+	for(int i = 0; i < N; i++)
+		for(int j = 0; j < N; j++)
+			evec[i][j] = (i == j) ? 1.0 : 0.0;
+
+	for(int sweep = 0; sweep < 50; sweep++)
+	{
+		bool rotated = false;
+
+		for(int p = 0; p < N - 1; p++)
+			for(int q = p + 1; q < N; q++)
+			{
+				//off-diagonal entries below the precision of the
+				//diagonal ones are zero for all purposes
+				double apq = a[p][q];
+				if( fabs(apq) <= 1e-18 * (fabs(a[p][p]) + fabs(a[q][q])) || apq == 0.0 )
+				{
+					a[p][q] = a[q][p] = 0.0;
+					continue;
+				}
+
+				//rotation by the angle which zeroes a[p][q]
+				double theta = (a[q][q] - a[p][p]) / (2.0 * apq);
+				double t = fabs(theta) > 1e150 ? 0.5 / theta
+								: (theta >= 0.0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta*theta + 1.0));
+				double c = 1.0 / sqrt(t*t + 1.0), s = t * c;
+
+				for(int k = 0; k < N; k++)
+				{
+					double akp = a[k][p], akq = a[k][q];
+					a[k][p] = c*akp - s*akq;
+					a[k][q] = s*akp + c*akq;
+				}
+				for(int k = 0; k < N; k++)
+				{
+					double apk = a[p][k], aqk = a[q][k];
+					a[p][k] = c*apk - s*aqk;
+					a[q][k] = s*apk + c*aqk;
+				}
+				for(int k = 0; k < N; k++)
+				{
+					double vkp = evec[k][p], vkq = evec[k][q];
+					evec[k][p] = c*vkp - s*vkq;
+					evec[k][q] = s*vkp + c*vkq;
+				}
+
+				rotated = true;
+			}
+
+		if(!rotated) break;
+	}
+
+	for(int i = 0; i < N; i++)
+		eval[i] = a[i][i];
+}
 
 #endif
\ No newline at end of file
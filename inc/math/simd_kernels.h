@@ -0,0 +1,64 @@
+#ifndef _SIMD_KERNELS_H_
+#define _SIMD_KERNELS_H_
+
+#include "../graph/convexity.h"
+
+// Vectorised kernels for the per-face and per-point math of mesh
+// preprocessing and posing. They work on raw arrays: positions, normals
+// and curvatures are packed x,y,z triples (the layout of
+// std::vector<glm::dvec3>) and faces are packed triples of node indexes
+// (the layout of std::vector<Face>).
+//
+// Every kernel comes in a scalar, an AVX2 (4 lanes) and an AVX-512
+// (8 lanes) version, picked at runtime. All of them do the same IEEE
+// operations in the same order (no FMA), so they give bitwise identical
+// results: the output never depends on the CPU it was computed on. The
+// only exception is the fused transform_points(), which must be asked
+// for (Parameters::FUSED_TRANSFORMS).
+
+enum SimdLevel
+{
+	SIMD_SCALAR = 0,
+	SIMD_AVX2 = 1,
+	SIMD_AVX512 = 2
+};
+
+//Widest kernels supported by the CPU, capped by Parameters::SIMD_LEVEL
+SimdLevel simd_level();
+const char* simd_level_name(SimdLevel level);
+
+//Approximation of acos(x) from Abramowitz & Stegun (4.4.46):
+//acos(x) = sqrt(1-x) * (a0 + a1*x + ... + a7*x^7) for x in [0, 1], and
+//acos(x) = pi - acos(-x) for negative x. The absolute error is at most
+//2.2e-8 rad over [-1, 1] (the 2e-8 of the book, plus the rounding of its
+//ten-digit coefficients: a0 is 2.18e-8 short of pi/2). Arguments out of [-1, 1] (rounding errors of the
+//caller) are clamped; NaN is propagated.
+double approx_acos(double x);
+
+//Curvature contribution of every corner of faces [begin, end): the unit
+//vector from the corner to the centroid of the face, scaled by the angle
+//of the face at that corner. The vector of corner k (a, b, c) of face f
+//is written to out[ 3*(3*f + k) .. 3*(3*f + k) + 2 ].
+void corner_curvatures(const double* positions, const int* faces, int begin, int end, double* out);
+
+//Classifies points [begin, end) by the sign of the dot product between
+//their curvature and the vector going from them to CENTROID: FLAT if it
+//is zero (up to EPS), CONVEX if it is positive, CONCAVE otherwise.
+void classify_convexity(const double* positions, const double* curvatures, const double centroid[3],
+						int begin, int end, Convexity* types);
+
+//Applies each of the K rigid transformations in POSES (K column-major
+//4x4 matrices: the layout of glm::dmat4) to points [begin, end):
+//positions as points, normals as directions. Pose j of point i goes to
+//triple j*(end - begin) + (i - begin) of OUT_POSITIONS / OUT_NORMALS.
+//Points go in blocks small enough to stay in L1 while every pose is
+//applied to them, so K poses cost a single pass over the cloud. Either
+//pair of arrays may be NULL to skip it. The results are bitwise those
+//of TransformedView::get_pos() and get_normal(), unless
+//Parameters::FUSED_TRANSFORMS is set: then the AVX2 (on CPUs with FMA)
+//and AVX-512 versions fuse the multiplies and adds, which is faster but
+//rounds differently (by an ulp or so; both fused versions agree).
+void transform_points(const double* positions, const double* normals, int begin, int end,
+					  const double* poses, int k, double* out_positions, double* out_normals);
+
+#endif
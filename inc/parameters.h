@@ -9,6 +9,19 @@ namespace Parameters
 	extern int PATCH_SIZE_THRESH;	//Minimal number of points inside a patch
 	extern int N_BEST_PAIRS;		//Number of complementary pairs we'll store for each patch in target
 	extern double G_THRESH;			//Geodesic threshold used for grouping
+	extern int N_THREADS;			//Worker threads for parallel passes (0 = one per hardware thread)
+	extern double CONTACT_DIST;		//Ligand points closer than this to the receptor surface are in contact
+	extern double CLASH_DEPTH;		//Ligand points deeper than this inside the receptor clash with it
+	extern double CLASH_PENALTY;	//Score lost by each clash (each contact adds 1)
+	extern int N_BEST_POSES;		//Number of best scoring poses kept for each ligand
+	extern double GRID_SPACING;		//Distance between the nodes of the receptor grids used for scoring
+	extern int ICP_MAX_ITERATIONS;	//Iterations of ICP refinement for each pose, at most
+	extern double ICP_MAX_DIST;		//Ligand points farther than this from the target are not paired by ICP
+	extern double ICP_TOLERANCE;	//ICP stops when an update rotates (rad) and moves less than this
+	extern double FFT_SPACING;		//Distance between the nodes of the grids of the FFT search
+	extern int FFT_ROTATIONS;		//Number of ligand rotations tried by the FFT search
+	extern int SIMD_LEVEL;			//Widest SIMD kernels to use (0 = scalar, 1 = AVX2, 2 = AVX-512), if the CPU supports them
+	extern int FUSED_TRANSFORMS;	//Pose points with FMAs where the CPU has them (faster, but not bitwise reproducible)
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,11 @@
+#ifndef _CHECKSUM_H_
+#define _CHECKSUM_H_
+
+#include <cstdint>
+#include <cstddef>
+
+//4-lane multiply-rotate hash over 64-bit words. It runs at memory speed,
+//which is all we need to tell a truncated or damaged file from a good one.
+uint64_t checksum(const char* data, size_t n);
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef _CONCURRENT_UNIONFIND_H_
+#define _CONCURRENT_UNIONFIND_H_
+
+#include <atomic>
+#include <memory>
+
+//Lock-free disjoint forest that many threads can merge into at the
+//same time. Roots are linked with a compare-and-swap, always hanging
+//the root with the larger index below the one with the smaller index,
+//so the root of every set ends up being its smallest element no matter
+//how merges were interleaved. find() halves paths as it goes.
+class ConcurrentUnionFind
+{
+private:
+	std::unique_ptr< std::atomic<int>[] > parent;
+	int n;
+
+	ConcurrentUnionFind(const ConcurrentUnionFind&) = delete;
+	ConcurrentUnionFind& operator=(const ConcurrentUnionFind&) = delete;
+
+public:
+	ConcurrentUnionFind(unsigned int n_elements);
+
+	unsigned int size() const { return n; }
+
+	//classical operations, safe to call concurrently
+	int find(int a);
+	void merge(int a, int b);
+};
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef _FLAT_ARRAY_H_
+#define _FLAT_ARRAY_H_
+
+#include <vector>
+#include <cstddef>
+#include "span.h"
+
+//Contiguous array which either owns its elements (in a std::vector) or
+//is a read-only view of elements owned by someone else, like the mapped
+//file of a cache, so that loading it copies nothing. Reading is the
+//same either way; writes go through own(), which first copies viewed
+//elements into the vector.
+template<typename T>
+class FlatArray
+{
+private:
+	std::vector<T> storage;
+	const T* viewed;	//NULL when the elements are in STORAGE
+	size_t n_viewed;
+
+public:
+	FlatArray() : viewed(NULL), n_viewed(0) { }
+
+	//Views the N elements at DATA, which must outlive the view
+	void view(const T* data, size_t n)
+	{
+		std::vector<T>().swap(storage);
+		viewed = data;
+		n_viewed = n;
+	}
+
+	std::vector<T>& own()
+	{
+		if(viewed)
+		{
+			storage.assign(viewed, viewed + n_viewed);
+			viewed = NULL;
+			n_viewed = 0;
+		}
+		return storage;
+	}
+
+	bool is_view() const { return viewed != NULL; }
+
+	const T* data() const { return viewed ? viewed : storage.data(); }
+	size_t size() const { return viewed ? n_viewed : storage.size(); }
+	bool empty() const { return size() == 0; }
+
+	const T* begin() const { return data(); }
+	const T* end() const { return data() + size(); }
+	const T& operator[](size_t i) const { return data()[i]; }
+
+	operator ConstSpan<T>() const { return ConstSpan<T>(begin(), end()); }
+};
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef _KD_TREE_H_
+#define _KD_TREE_H_
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "span.h"
+
+// Static k-d tree over a point cloud, for nearest neighbour queries.
+// It is stored implicitly: the points of a subtree are a range of the
+// array, split by its middle point, so the tree is a single array and
+// is read-only once built. Any number of threads can query it at once.
+class KDTree
+{
+private:
+	typedef struct {
+		glm::dvec3 pos;
+		int id;			//index of the point in the cloud the tree was built from
+		int axis;		//axis splitting the subtree rooted at this point
+	} Node;
+
+	std::vector<Node> nodes;
+
+	void build(int begin, int end);
+	void search(int begin, int end, const glm::dvec3& p, int& best, double& best_dist2) const;
+
+public:
+	explicit KDTree(ConstSpan<glm::dvec3> cloud);
+
+	int size() const { return nodes.size(); }
+
+	//Index (in the cloud) of the point nearest to P, if it is closer
+	//than MAX_DIST; -1 otherwise. DIST2 is set to its squared distance.
+	int nearest(const glm::dvec3& p, double max_dist, double& dist2) const;
+};
+
+#endif
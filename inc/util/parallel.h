@@ -0,0 +1,24 @@
+#ifndef _PARALLEL_H_
+#define _PARALLEL_H_
+
+#include <functional>
+
+//Number of worker threads parallel loops should use. It is
+//Parameters::N_THREADS, or the number of hardware threads
+//if that is zero (or negative).
+int worker_count();
+
+//Splits [begin, end) into at most worker_count() contiguous chunks
+//of (almost) the same size and runs BODY(chunk_begin, chunk_end, chunk)
+//on each of them in parallel. It returns when all chunks are done.
+//Chunk boundaries only depend on the range and the number of workers,
+//so a body which writes to disjoint slots per index gives the same
+//result whatever the number of threads.
+void parallel_for(int begin, int end, const std::function<void(int, int, int)>& body);
+
+//Makes parallel_for run serially (as a single chunk) when called from
+//this thread. Used by threads which already run in parallel with each
+//other, like the workers of a ThreadPool.
+void set_thread_serial(bool serial);
+
+#endif
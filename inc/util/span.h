@@ -0,0 +1,32 @@
+#ifndef _SPAN_H_
+#define _SPAN_H_
+
+#include <cstddef>
+#include <vector>
+
+//Read-only view over a contiguous range of elements owned by
+//someone else (typically a slice of a std::vector). It's just
+//a pair of pointers, so it's cheap to pass around by value.
+template<typename T>
+class ConstSpan
+{
+private:
+	const T* first;
+	const T* last;
+
+public:
+	ConstSpan() : first(NULL), last(NULL) { }
+	ConstSpan(const T* first, const T* last) : first(first), last(last) { }
+	ConstSpan(const std::vector<T>& v) : first(v.data()), last(v.data() + v.size()) { }
+
+	const T* begin() const { return first; }
+	const T* end() const { return last; }
+	const T* data() const { return first; }
+
+	size_t size() const { return last - first; }
+	bool empty() const { return first == last; }
+
+	const T& operator[](size_t i) const { return first[i]; }
+};
+
+#endif
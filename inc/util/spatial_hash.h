@@ -0,0 +1,34 @@
+#ifndef _SPATIAL_HASH_H_
+#define _SPATIAL_HASH_H_
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// Uniform grid over R³, stored sparsely in a hash map, which buckets
+// integer ids by the cell of a point. With cells as wide as a search
+// radius, everything within that radius of a point is in the 27 cells
+// around it, so a radius query only looks at those.
+class SpatialHash
+{
+private:
+	double cell_size;
+	std::unordered_map< uint64_t, std::vector<int> > cells;
+
+	uint64_t key(int64_t x, int64_t y, int64_t z) const;
+
+public:
+	explicit SpatialHash(double cell_size);
+
+	//Adds ID to the cell of P. Inserting the same id twice in the
+	//cell of its last insertion is a no-op.
+	void insert(const glm::dvec3& p, int id);
+
+	//Appends to OUT the ids inserted in the 27 cells around P, which
+	//include all the ids inserted at less than cell_size from P (and
+	//maybe others, farther). Ids may be repeated.
+	void near(const glm::dvec3& p, std::vector<int>& out) const;
+};
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef _THREAD_POOL_H_
+#define _THREAD_POOL_H_
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+// Pool of worker threads running independent tasks of very different
+// lengths (e.g. docking ligands of any size). Every worker has its own
+// deque: it takes its tasks from the back, and when it runs out it
+// steals from the front of the others, so no worker stays idle while
+// some other one has a backlog. Tasks submitted from outside the pool
+// are dealt round-robin; tasks submitted by a task stay in its worker.
+//
+// While running a task, parallel_for() runs serially on the worker: the
+// pool already keeps every core busy with independent tasks.
+class ThreadPool
+{
+private:
+	typedef struct {
+		std::deque< std::function<void()> > tasks;
+		std::mutex lock;
+	} TaskQueue;
+
+	std::vector< std::unique_ptr<TaskQueue> > queues;
+	std::vector<std::thread> workers;
+
+	//queued counts tasks waiting in some deque, pending the ones not
+	//finished yet. Idle workers sleep on has_work, wait() on all_done.
+	std::atomic<int> queued, pending;
+	std::mutex state_lock;
+	std::condition_variable has_work, all_done;
+	bool stopping;
+
+	unsigned int next_queue;
+
+	void worker_loop(int id);
+	bool take_task(int id, std::function<void()>& task);
+
+public:
+	//N_WORKERS <= 0 means one per hardware thread (see worker_count())
+	explicit ThreadPool(int n_workers = 0);
+
+	//Waits for the pending tasks, then stops the workers
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	int size() const { return workers.size(); }
+
+	void submit(const std::function<void()>& task);
+
+	//Blocks until every task submitted so far is finished. It must
+	//not be called from a task of the same pool.
+	void wait();
+};
+
+#endif
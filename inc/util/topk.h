@@ -0,0 +1,66 @@
+#ifndef _TOPK_H_
+#define _TOPK_H_
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+
+// Selects the K least elements (according to LESS) of a stream, with a
+// bounded max-heap: every push is O(log K), whatever the length of the
+// stream, and fewer than K elements are simply all kept. reset() keeps
+// the storage, so a TopK reused across queries stops allocating once
+// it has grown to K elements.
+template<typename T, typename Less = std::less<T> >
+class TopK
+{
+private:
+	std::vector<T> heap;	//max-heap: the worst kept element is at the front
+	int k;
+	Less less;
+
+public:
+	explicit TopK(int k = 0, const Less& less = Less()) : k(0), less(less) { reset(k); }
+
+	//Drops the elements and starts selecting the K least
+	void reset(int k)
+	{
+		this->k = k > 0 ? k : 0;
+		heap.clear();
+		heap.reserve(this->k);
+	}
+
+	int size() const { return heap.size(); }
+	bool full() const { return (int)heap.size() >= k; }
+
+	//Worst element kept so far; only valid if size() > 0
+	const T& worst() const { return heap.front(); }
+
+	//Offers X; returns whether it was kept
+	bool push(const T& x)
+	{
+		if(k == 0) return false;
+
+		if( !full() )
+		{
+			heap.push_back(x);
+			std::push_heap(heap.begin(), heap.end(), less);
+			return true;
+		}
+
+		if( !less(x, heap.front()) ) return false;
+
+		std::pop_heap(heap.begin(), heap.end(), less);
+		heap.back() = x;
+		std::push_heap(heap.begin(), heap.end(), less);
+		return true;
+	}
+
+	//Copies the kept elements to OUT, least first
+	void sorted(std::vector<T>& out) const
+	{
+		out.assign(heap.begin(), heap.end());
+		std::sort(out.begin(), out.end(), less);
+	}
+};
+
+#endif
@@ -4,26 +4,33 @@
 #include <vector>
 
 //Implement as a disjoint forest. The vector
-//*parent stores the parent of each node.
+//parent stores the parent of each node.
 //the root of a tree is such that it is its
-//own parent.
+//own parent. Sets are linked by size and paths
+//are halved on every find, so trees stay shallow
+//and find() never needs to recurse.
 class UnionFind
 {
 private:
-	int* parent;
-	int n;
+	//path halving only shortcuts the forest, it doesn't change
+	//which sets exist, so find() can do it and still be const
+	mutable std::vector<int> parent;
+	std::vector<int> set_size;
 
 public:
 	UnionFind(unsigned int n_elements);
-	~UnionFind();
+
+	unsigned int size() const { return parent.size(); }
 
 	//classical operations
 	int find(int a) const;
 	void merge(int a, int b);
 
-	//extra-operation: return a list of lists,
-	//each one with a cluster (a disjoint set)
-	void clusters(std::vector< std::vector<int> >& clusters) const;
+	//extra-operation: return every cluster (a disjoint set) in
+	//compressed form: the elements of cluster k are
+	//members[ offsets[k] .. offsets[k+1] ), in increasing order.
+	//Clusters are numbered by their smallest element.
+	void clusters(std::vector<int>& offsets, std::vector<int>& members) const;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -2,54 +2,183 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <chrono>
 
 #include <glm/gtx/string_cast.hpp>
 
 #include "./inc/docker/docker.h"
+#include "./inc/docker/screening.h"
+#include "./inc/docker/scoring.h"
+#include "./inc/docker/fft_docker.h"
+#include "./inc/docker/icp.h"
 #include "./inc/graph/graph.h"
 #include "./inc/io/fileio.h"
 #include "./inc/visualization/render.h"
 #include "./inc/parameters.h"
 
+static void report_load(const std::string& name, const LoadStats& stats)
+{
+	double mb = stats.bytes / (1024.0 * 1024.0);
+	std::cout<<"Loaded "<<name<<(stats.from_cache ? " (cache)" : "")<<": "<<mb<<" MB in "<<stats.seconds * 1000.0<<" ms ("
+			 <<(stats.seconds > 0.0 ? mb / stats.seconds : 0.0)<<" MB/s)"<<std::endl;
+}
+
+//Optional parameters, starting at args[first]
+static void read_parameters(int argc, char** args, int first)
+{
+	if(argc > first) Parameters::PATCH_SIZE_THRESH = atoi( args[first] );
+	if(argc > first + 1) Parameters::N_BEST_PAIRS = atoi( args[first + 1] );
+	if(argc > first + 2) Parameters::G_THRESH = atoi( args[first + 2] );
+}
+
+//Screens every ligand listed in a manifest against one receptor:
+//	keypoints --batch RECEPTOR MANIFEST OUTDIR [parameters]
+static int run_batch(int argc, char** args)
+{
+	if(argc < 5) {
+		std::cerr<<"Usage: "<<args[0]<<" --batch RECEPTOR MANIFEST OUTDIR [PATCH_SIZE_THRESH N_BEST_PAIRS G_THRESH]"<<std::endl;
+		return 1;
+	}
+
+	std::string receptor_name(args[2]), manifest(args[3]), outdir(args[4]);
+	read_parameters(argc, args, 5);
+
+	std::vector<std::string> ligands;
+	if(!Screening::read_manifest(manifest, ligands)) return 1;
+
+	//the receptor is preprocessed once and shared by all ligands
+	LoadStats stats;
+	Graph receptor; SurfaceDescriptors desc_receptor;
+	if(!FileIO().surface_from_file(receptor_name, receptor, desc_receptor, &stats)) return 1;
+	report_load(receptor_name, stats);
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	std::vector<ScreeningResult> results;
+	Screening(receptor, desc_receptor, receptor_name + ".spgr").run(ligands, outdir, results);
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	int failed = 0;
+	for(auto r = results.begin(); r != results.end(); ++r)
+		if(!r->ok) failed++;
+
+	std::cout<<"Screened "<<results.size()<<" ligands ("<<failed<<" failed) in "<<elapsed.count()<<" s ("
+			 <<(elapsed.count() > 0.0 ? results.size() / elapsed.count() : 0.0)<<" ligands/s)"<<std::endl;
+
+	return failed == (int)ligands.size() && failed > 0 ? 1 : 0;
+}
+
+//Exhaustive FFT search, the baseline for the patch-based docking:
+//	keypoints --fft RECEPTOR LIGAND [FFT_ROTATIONS]
+static int run_fft(int argc, char** args)
+{
+	if(argc < 4) {
+		std::cerr<<"Usage: "<<args[0]<<" --fft RECEPTOR LIGAND [FFT_ROTATIONS]"<<std::endl;
+		return 1;
+	}
+
+	std::string receptor_name(args[2]), ligand_name(args[3]);
+	if(argc > 4) Parameters::FFT_ROTATIONS = atoi( args[4] );
+
+	LoadStats stats;
+	Graph receptor; SurfaceDescriptors desc_receptor;
+	if(!FileIO().surface_from_file(receptor_name, receptor, desc_receptor, &stats)) return 1;
+	report_load(receptor_name, stats);
+
+	Graph ligand; SurfaceDescriptors desc_ligand;
+	if(!FileIO().surface_from_file(ligand_name, ligand, desc_ligand, &stats)) return 1;
+	report_load(ligand_name, stats);
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	Scoring scoring(receptor, receptor_name + ".spgr");
+	std::vector<FFTPose> poses;
+	FFTDocker(receptor, scoring).dock(ligand, poses);
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	for(auto pose = poses.begin(); pose != poses.end(); ++pose)
+	{
+		std::cout<<"Pose "<<pose->score.pose<<" (rotation "<<pose->rotation<<"): correlation "<<pose->correlation
+				 <<", score "<<pose->score.score<<" ("<<pose->score.contacts<<" contacts, "<<pose->score.clashes<<" clashes)"<<std::endl;
+		std::cout<<glm::to_string(pose->transform)<<std::endl<<std::endl;
+	}
+
+	std::cout<<"Searched "<<Parameters::FFT_ROTATIONS<<" rotations in "<<elapsed.count()<<" s ("
+			 <<(elapsed.count() > 0.0 ? Parameters::FFT_ROTATIONS / elapsed.count() : 0.0)<<" rotations/s)"<<std::endl;
+
+	return 0;
+}
+
 int main(int argc, char** args)
 {
+	if(argc > 1 && std::string(args[1]) == "--batch") return run_batch(argc, args);
+	if(argc > 1 && std::string(args[1]) == "--fft") return run_fft(argc, args);
+
 	std::string fname(args[1]);
-	std::string vertfile(fname + ".vert");
-	std::string facefile(fname + ".face");
 
 	//Process arguments
-	if(argc > 2) Parameters::PATCH_SIZE_THRESH = atoi( args[2] );
-	if(argc > 3) Parameters::N_BEST_PAIRS = atoi( args[3] );
-	if(argc > 4) Parameters::G_THRESH = atoi( args[4] );
+	read_parameters(argc, args, 2);
 
 	//preprocess input molecules
+	FileIO io; Docker docker;
+	LoadStats stats;
+
 	Graph target; SurfaceDescriptors desc_target;
-	FileIO::instance()->mesh_from_file(vertfile, facefile, target);
-	target.preprocess_mesh(desc_target);
+	if(!io.surface_from_file(fname, target, desc_target, &stats)) return 1;
+	report_load(fname, stats);
 
 	Graph ligand; SurfaceDescriptors desc_ligand;
-	FileIO::instance()->mesh_from_file(vertfile, facefile, ligand);
-	ligand.preprocess_mesh(desc_ligand);
+	if(!io.surface_from_file(fname, ligand, desc_ligand, &stats)) return 1;
+	report_load(fname, stats);
 
 	//build matching groups
 	std::vector<MatchingGroup> matching_groups;
-	Docker::instance()->build_matching_groups(desc_target, desc_ligand, matching_groups);
+	if(!docker.build_matching_groups(target, desc_target, ligand, desc_ligand, matching_groups)) return 1;
 
 	//build transformations matrices that align matching groups
 	std::vector<glm::dmat4> mg_transformation;
-	Docker::instance()->transformations_from_matching_groups(matching_groups, 
-															target, desc_target, 
-															ligand, desc_ligand, 
-															mg_transformation);
+	docker.transformations_from_matching_groups(matching_groups, 
+												target, desc_target, 
+												ligand, desc_ligand, 
+												mg_transformation);
+
+	//refine every transformation with ICP
+	std::vector<ICPResult> refinement;
+	ICP(target).refine_groups(matching_groups, ligand, desc_ligand, mg_transformation, refinement);
+
+	int converged = 0, iterations = 0; double icp_seconds = 0.0;
+	for(auto r = refinement.begin(); r != refinement.end(); ++r)
+	{
+		converged += r->converged;
+		iterations += r->iterations;
+		icp_seconds += r->seconds;
+	}
+
+	if(!refinement.empty())
+		std::cout<<"Refined "<<refinement.size()<<" poses: "<<converged<<" converged, "
+				 <<(double)iterations / refinement.size()<<" iterations and "
+				 <<icp_seconds * 1000.0 / refinement.size()<<" ms per pose"<<std::endl;
+
+	//score every transformation, and keep the best ones only
+	std::vector<PoseScore> ranked;
+	Scoring(target, fname + ".spgr").rank(ligand, mg_transformation, ranked);
+	if( (int)ranked.size() > Parameters::N_BEST_POSES ) ranked.resize( std::max(Parameters::N_BEST_POSES, 0) );
 
-	//docking phase: align cloud points according to calculated transformations
+	//docking phase: pose the ligand with each transformation (drawing reads it through the pose)
 	ligand.set_base_color( glm::vec3(0.0, 0.7, 0.7) );
 	target.set_base_color( glm::vec3(0.7, 0.7, 0.7) );
 
-	for(auto trans = mg_transformation.begin(); trans != mg_transformation.end(); ++trans)
+	for(auto pose = ranked.begin(); pose != ranked.end(); ++pose)
 	{
-		ligand.transform_cloud(*trans);
-		std::cout<<glm::to_string(*trans)<<std::endl<<std::endl;
+		const glm::dmat4& trans = mg_transformation[pose->pose];
+		ligand.transform_cloud(trans);
+		const ICPResult& icp = refinement[pose->pose];
+		std::cout<<"Pose "<<pose->pose<<": score "<<pose->score<<" ("<<pose->contacts<<" contacts, "
+				 <<pose->clashes<<" clashes), ICP "<<(icp.converged ? "converged" : "stopped")<<" after "
+				 <<icp.iterations<<" iterations in "<<icp.seconds * 1000.0<<" ms (RMS "<<icp.rms<<")"<<std::endl;
+		std::cout<<glm::to_string(trans)<<std::endl<<std::endl;
 		Render::instance()->draw_meshes(ligand, target);
 	}
 
@@ -0,0 +1,86 @@
+#include "../../inc/docker/descriptor_index.h"
+
+//------------------------------------------------------
+//--------------------- INTERNAL -----------------------
+//------------------------------------------------------
+//Rounding may make the distances along a walk decrease by an ulp or
+//so; we keep walking past the K-th distance by this relative margin
+//so such candidates aren't missed (the selection puts them in place).
+static const double WALK_SLACK = 1e-12;
+
+//Curvatures are sorted in the same order as candidates
+static const CandidateOrder closer = CandidateOrder();
+
+//Walk over a sorted LIST, one step at a time, from NEXT towards STOP
+//(excluded). STEP is -1 for the left side and +1 for the right one.
+typedef struct {
+	const std::vector< std::pair<double, int> >* list;
+	int next, stop, step;
+} Walk;
+
+//---------------------------------------------------------
+//----------------- FROM DESCRIPTOR_INDEX.H ---------------
+//---------------------------------------------------------
+DescriptorIndex::DescriptorIndex(const std::vector< std::pair<Patch, Descriptor> >& desc)
+{
+	for(int t = 0; t < 3; t++) all_positive[t] = true;
+
+	for(unsigned int i = 0; i < desc.size(); i++)
+	{
+		const Descriptor& d = desc[i].second;
+		by_type[d.type].push_back( std::make_pair(d.curv, i) );
+
+		//also false for NaN
+		if( !(d.curv > 0.0) ) all_positive[d.type] = false;
+	}
+
+	for(int t = 0; t < 3; t++)
+		std::sort(by_type[t].begin(), by_type[t].end(), closer);
+}
+
+void DescriptorIndex::most_complementary(const Descriptor& d, int k, CandidateSelection& best) const
+{
+	best.reset(k);
+	if(k <= 0) return;
+
+	Walk walks[4]; int n_walks = 0;
+
+	for(int t = 0; t < 3; t++)
+	{
+		const std::vector<Entry>& list = by_type[t];
+		if(t == d.type || list.empty()) continue;
+
+		if( all_positive[t] && d.curv > 0.0 && std::isfinite(d.curv) )
+		{
+			//first entry with curvature >= d.curv; walk both ways from it
+			int mid = std::lower_bound(list.begin(), list.end(), std::make_pair(d.curv, -1), closer) - list.begin();
+			walks[n_walks++] = (Walk){ &list, mid - 1, -1, -1 };
+			walks[n_walks++] = (Walk){ &list, mid, (int)list.size(), 1 };
+		}
+		else
+		{
+			for(auto e = list.begin(); e != list.end(); ++e)
+				best.push( std::make_pair(curvature_distance(d.curv, e->first), e->second) );
+		}
+	}
+
+	//merge the walks in order of distance until we have K candidates
+	//and the next ones are all farther than the worst of them
+	while(true)
+	{
+		int next = -1; double next_dist = 0.0;
+		for(int w = 0; w < n_walks; w++)
+		{
+			if(walks[w].next == walks[w].stop) continue;
+
+			double dist = curvature_distance(d.curv, (*walks[w].list)[ walks[w].next ].first);
+			if(next < 0 || dist < next_dist) { next = w; next_dist = dist; }
+		}
+
+		if(next < 0) break;
+		if( best.full() && next_dist > best.worst().first * (1.0 + WALK_SLACK) ) break;
+
+		best.push( std::make_pair(next_dist, (*walks[next].list)[ walks[next].next ].second) );
+		walks[next].next += walks[next].step;
+	}
+}
@@ -1,140 +1,261 @@
 #include "../../inc/docker/docker.h"
 #include "../../inc/parameters.h"
 #include "../../inc/math/linalg.h"
+#include "../../inc/util/spatial_hash.h"
+#include "../../inc/util/parallel.h"
 #include <glm/gtx/string_cast.hpp>
 #include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtc/quaternion.hpp>
-#include <glm/gtc/constants.hpp>
 #include <algorithm>
 #include <iostream>
-#include <set>
-
-Docker* Docker::docker_ptr = 0;
 
 //------------------------------------------------------
 //--------------------- INTERNAL -----------------------
 //------------------------------------------------------
-// This computes the geodesic distance between two patches
-static int geodesic_distance(int lhs_patch_ind, int rhs_patch_ind, const SurfaceDescriptors& desc)
+// This computes the geodesic distance between two patches: the
+// length of the shortest path along the surface between their seeds,
+// precomputed by Graph::preprocess_mesh() up to G_THRESH (+infinity
+// past that).
+static float geodesic_distance(int lhs_patch_ind, int rhs_patch_ind, const Graph& graph)
 {
-	const Patch& lhs_patch = desc[lhs_patch_ind].first;
-	const Patch& rhs_patch = desc[rhs_patch_ind].first;
+	return graph.get_patch_geodesics().distance(lhs_patch_ind, rhs_patch_ind);
+}
 
-	//First version: just compute euclidean distance between patches centroid
-	glm::dvec3 n1 = lhs_patch.get_pos();
-	glm::dvec3 n2 = rhs_patch.get_pos();
+//Position of the seed of a patch, where its geodesic distances are measured from
+static glm::dvec3 seed_pos(int patch_ind, const Graph& graph, const SurfaceDescriptors& desc)
+{
+	return graph.get_pos( desc[patch_ind].first.get_seed() );
+}
 
-	return glm::length(n1-n2);
+// Centroid and unit average normal of a patch, from the positions and
+// normals of its surface as loaded (unposed: any transform_cloud() pose
+// is ignored). It only reads, so groups can be aligned in parallel
+// without allocating.
+static void patch_frame(const Patch& patch, const Graph& graph, glm::dvec3& centroid, glm::dvec3& normal)
+{
+	centroid = glm::dvec3(0.0); normal = glm::dvec3(0.0);
+	for(auto n = patch.nodes.begin(); n != patch.nodes.end(); ++n)
+	{
+		centroid += graph.get_pos(*n);
+		normal += graph.get_normal(*n);
+	}
+
+	centroid /= (double)patch.nodes.size();
+	double len = glm::length(normal);
+	if(len > 0.0) normal /= len;
 }
 
-// This compares two points in R³
-static bool comp_point(const glm::dvec3& lhs, const glm::dvec3& rhs)
+// Rigid transformation which best aligns the ligand patches of a
+// matching group onto their target patches: the centroids of matched
+// patches are brought together (in the least-squares sense) and their
+// normals made to face each other. Normals are directions, not points,
+// so they only weigh on the rotation; they count as much as the
+// centroids do (weighted by the spread of the ligand centroids), and
+// alone fix it when there's a single pair.
+static glm::dmat4 align_group(const MatchingGroup& group,
+							  const Graph& target, const SurfaceDescriptors& desc_target,
+							  const Graph& ligand, const SurfaceDescriptors& desc_ligand)
 {
-	if( lhs[0] != rhs[0] ) return lhs[0] < rhs[0];
-	if( lhs[1] != rhs[1] ) return lhs[1] < rhs[1];
-	if( lhs[2] != rhs[2] ) return lhs[2] < rhs[2];
+	//correlations of the centroids and of the normals (the ligand ones
+	//against the flipped target ones), in a single pass: the centroids
+	//are centered afterwards, with sum( a b^T ) - n mean(a) mean(b)^T
+	glm::dvec3 target_mean(0.0), ligand_mean(0.0);
+	double m_points[3][3] = {{0.0}}, m_normals[3][3] = {{0.0}};
+	double spread = 0.0;
+	for(auto p = group.begin(); p != group.end(); ++p)
+	{
+		glm::dvec3 tc, tn, lc, ln;
+		patch_frame(desc_target[p->first].first, target, tc, tn);
+		patch_frame(desc_ligand[p->second].first, ligand, lc, ln);
+
+		target_mean += tc; ligand_mean += lc;
+		spread += glm::dot(lc, lc);
+		for(int j = 0; j < 3; j++)
+			for(int k = 0; k < 3; k++)
+			{
+				m_points[j][k] += lc[j] * tc[k];
+				m_normals[j][k] -= ln[j] * tn[k];
+			}
+	}
+
+	double n = group.size();
+	target_mean /= n; ligand_mean /= n;
+	spread = spread / n - glm::dot(ligand_mean, ligand_mean);
+	for(int j = 0; j < 3; j++)
+		for(int k = 0; k < 3; k++) m_points[j][k] -= n * ligand_mean[j] * target_mean[k];
+
+	//a single pair has no spread (up to rounding)
+	double weight = spread > 1e-9 ? spread : 1.0;
+	double m[3][3];
+	for(int j = 0; j < 3; j++)
+		for(int k = 0; k < 3; k++)
+			m[j][k] = m_points[j][k] + weight * m_normals[j][k];
+
+	//send the ligand centroid to the origin, rotate, bring it to the target one
+	return glm::translate(glm::dmat4(1.0), target_mean)
+			* glm::dmat4( optimal_rotation(m) )
+			* glm::translate(glm::dmat4(1.0), -ligand_mean);
+}
+
+// Grouping: a pair (t,l) joins every group whose pairs all have their
+// target patch at most G_THRESH away from t and their ligand patch at
+// most G_THRESH away from l, along the surface. A path along the surface
+// is never shorter than the straight line, so nothing farther than
+// G_THRESH in space can be close enough: groups are found through a
+// spatial hash of the seeds of the target patches of their pairs, with
+// cells as wide as G_THRESH, so only groups with some pair around t are
+// looked at. Each group also keeps the bounding boxes of the seeds of
+// its target and ligand patches, which reject most pairs without
+// looking at every member.
+
+//Relative margin for the bounding box and hash tests, so that they
+//never disagree with geodesic_distance() because of rounding
+static const double BOX_MARGIN = 1e-9;
+
+typedef struct {
+	glm::dvec3 lo, hi;
+} Box;
 
-	//lhs is equal to rhs, so is not less then rhs
-	return false;
+static Box box_around(const glm::dvec3& p) { return (Box){ p, p }; }
+
+static void box_extend(Box& box, const glm::dvec3& p)
+{
+	box.lo = glm::min(box.lo, p);
+	box.hi = glm::max(box.hi, p);
 }
 
-// This merges all patches of a group into a single cloud point
-// and, at the same, computes the average normal of the cloud.
-// 'though it's not nice to merge different operations in a single
-// function, this is faster then computing separately.
-static void build_cloud_from_group(const std::vector<int>& group,
-									const SurfaceDescriptors& descriptors, 
-									const Graph& target, 
-									std::vector<glm::dvec3>& cloud_out,
-									glm::dvec3& avg_normal)
+//Least distance from P to a point of BOX
+static double box_min_distance(const Box& box, const glm::dvec3& p)
 {
-	avg_normal = glm::dvec3(0.0, 0.0, 0.0);
+	return glm::length( glm::max(glm::max(box.lo - p, p - box.hi), glm::dvec3(0.0)) );
+}
 
-	//we'll use a BST to store all points without repeating
-	std::set<glm::dvec3,bool(*)(const glm::dvec3&,const glm::dvec3&)> cloud(comp_point);
+typedef struct {
+	Box target, ligand;
+} GroupBounds;
 
-	//we'll loop through all patches inside GROUP
-	for(auto desc_pair = group.begin(); desc_pair != group.end(); ++desc_pair)
-	{
-		const Patch& patch = descriptors[*desc_pair].first;
+static bool group_accepts(const MatchingGroup& grp, const GroupBounds& bounds, const std::pair<int,int>& cur_pair,
+						  const Graph& target, const Graph& ligand,
+						  const glm::dvec3& t_pos, const glm::dvec3& l_pos)
+{
+	//geodesics are stored in single precision, so they're compared
+	//with the threshold in single precision too
+	const float thresh = Parameters::G_THRESH;
+	const double reach = Parameters::G_THRESH * (1.0 + BOX_MARGIN);
 
-		// accumulate normal
-		avg_normal = avg_normal + patch.get_normal();
+	if( box_min_distance(bounds.target, t_pos) > reach ) return false;
+	if( box_min_distance(bounds.ligand, l_pos) > reach ) return false;
 
-		// put every point inside this patch into the cloud.
-		for(auto p = patch.nodes.begin(); p != patch.nodes.end(); ++p)
-			cloud.insert( target.get_node(*p).get_pos() );
+	for(auto pair = grp.begin(); pair != grp.end(); ++pair)
+	{
+		if( geodesic_distance(cur_pair.first, pair->first, target) > thresh ) return false;
+		if( geodesic_distance(cur_pair.second, pair->second, ligand) > thresh ) return false;
 	}
 
-	//copy set to vector
-	cloud_out = std::vector<glm::dvec3>( cloud.begin(), cloud.end() );
-
-	// compute average normal
-	avg_normal = glm::normalize( avg_normal * (1.0 / group.size()) );
+	return true;
 }
 
 //-----------------------------------------------------------
 //--------------------- FROM DOCKER.H -----------------------
 //-----------------------------------------------------------
-void Docker::build_matching_groups(const SurfaceDescriptors& desc_target, 
-									const SurfaceDescriptors& desc_ligand, 
+bool Docker::build_matching_groups(const Graph& target, const SurfaceDescriptors& desc_target,
+									const Graph& ligand, const SurfaceDescriptors& desc_ligand,
 									std::vector<MatchingGroup>& groups_out) const
 {
+	return build_matching_groups(target, desc_target, ligand, desc_ligand, DescriptorIndex(desc_ligand), groups_out);
+}
+
+bool Docker::build_matching_groups(const Graph& target, const SurfaceDescriptors& desc_target,
+									const Graph& ligand, const SurfaceDescriptors& desc_ligand,
+									const DescriptorIndex& ligand_index,
+									std::vector<MatchingGroup>& groups_out) const
+{
+	//geodesics are computed along with the descriptors; both must
+	//come from the same preprocessing
+	if( target.get_patch_geodesics().size() != (int)desc_target.size() ||
+		ligand.get_patch_geodesics().size() != (int)desc_ligand.size() )
+	{
+		std::cerr<<"Patch geodesics missing, surfaces must be preprocessed before grouping"<<std::endl;
+		return false;
+	}
+
+	if( target.get_patch_geodesics().get_cutoff() < Parameters::G_THRESH ||
+		ligand.get_patch_geodesics().get_cutoff() < Parameters::G_THRESH )
+	{
+		std::cerr<<"Patch geodesics were computed for a smaller G_THRESH"<<std::endl;
+		return false;
+	}
+
+	//This list stores pairs <D,I>, where I is the index of a
+	//LIGAND patch and D is the dissimilary distance between
+	//the current TARGET patch and I. Both buffers are reused
+	//for every target patch.
+	CandidateSelection best;
+	std::vector<Candidate> similarity_list;
+
+	//No pair is ever close enough with a negative threshold
+	//(distances are >= 0), so every pair gets a group of its own
+	const bool grouping = Parameters::G_THRESH >= 0.0;
+	const double cell = Parameters::G_THRESH > 0.0 ? Parameters::G_THRESH * (1.0 + 2.0*BOX_MARGIN) : 1.0;
+
+	SpatialHash groups_near(cell);
+	std::vector<GroupBounds> bounds;
+	std::vector<int> candidates, seen;
+
+	//groups already in GROUPS_OUT take part too
+	for(unsigned int g = 0; g < groups_out.size(); g++)
+	{
+		GroupBounds b = { box_around(glm::dvec3(0.0)), box_around(glm::dvec3(0.0)) };
+		for(auto pair = groups_out[g].begin(); pair != groups_out[g].end(); ++pair)
+		{
+			glm::dvec3 t_pos = seed_pos(pair->first, target, desc_target);
+			glm::dvec3 l_pos = seed_pos(pair->second, ligand, desc_ligand);
+
+			if(pair == groups_out[g].begin()) b = (GroupBounds){ box_around(t_pos), box_around(l_pos) };
+			else { box_extend(b.target, t_pos); box_extend(b.ligand, l_pos); }
+
+			groups_near.insert(t_pos, g);
+		}
+		bounds.push_back(b);
+		seen.push_back(-1);
+	}
+
 	//loop over all patches in target surface, get the
 	//most similar and complementary patches from ligand,
 	//then try to group it. 
-	for(int t = 0; t < desc_target.size(); ++t)
+	for(int t = 0, query = 0; t < (int)desc_target.size(); ++t)
 	{
-		const std::pair<Patch,Descriptor> &t_patch = desc_target[t];
-
-		//This list stores pairs <D,I>, where I is the index of a
-		//LIGAND patch and D is the dissimilary distance between
-		//the current TARGET patch and I. It is inverted so we
-		//can use lexicographical order for sorting
-		std::vector< std::pair<double,int> > similarity_list;
-		for(int l = 0; l < desc_ligand.size(); ++l)
-		{	
-			const std::pair<Patch,Descriptor> &l_patch = desc_ligand[l];
-			
-			if(t_patch.second.type != l_patch.second.type)
-			{
-				double dist = fabs(t_patch.second.curv - l_patch.second.curv) / std::max(t_patch.second.curv, l_patch.second.curv);
-				similarity_list.push_back( std::make_pair(dist, l) );
-			}
-		}
+		//get the K patches of opposite convexity most similar
+		//to the current TARGET patch, most similar first
+		ligand_index.most_complementary(desc_target[t].second, Parameters::N_BEST_PAIRS, best);
+		best.sorted(similarity_list);
 
-		//sort similarity list according to distance. This will
-		//give us a list of the patches in the LIGAND which are
-		//most similar to t_patch (which is the current TARGET 
-		//patch we're treating.
-		std::sort(similarity_list.begin(), similarity_list.end());
-
-		//get the K patches most similar to t_patch
-		similarity_list.erase( similarity_list.begin() + Parameters::N_BEST_PAIRS, similarity_list.end() );
+		glm::dvec3 t_pos = seed_pos(t, target, desc_target);
 
 		//try to group pairs together
-		for(auto lig = similarity_list.begin(); lig != similarity_list.end(); ++lig)
+		for(auto lig = similarity_list.begin(); lig != similarity_list.end(); ++lig, ++query)
 		{
 			bool added = false;
 
 			//build the current pair we're treating
 			std::pair<int,int> cur_pair = std::make_pair(t, lig->second);
+			glm::dvec3 l_pos = seed_pos(cur_pair.second, ligand, desc_ligand);
 
-			for(auto grp = groups_out.begin(); grp != groups_out.end(); ++grp)
-			{
-				bool grouping_crit = true;
+			//groups with some pair around t, each one once
+			candidates.clear();
+			if(grouping) groups_near.near(t_pos, candidates);
 
-				//check distances
-				for(auto pair = grp->begin(); pair != grp->end(); ++pair)
-				{
-					if( geodesic_distance(cur_pair.first, pair->first, desc_target) > Parameters::G_THRESH ) grouping_crit = false;
-					if( geodesic_distance(cur_pair.second, pair->second, desc_ligand) > Parameters::G_THRESH ) grouping_crit = false;
-				}
+			for(auto g = candidates.begin(); g != candidates.end(); ++g)
+			{
+				if(seen[*g] == query) continue;
+				seen[*g] = query;
 
 				//if group criterion holds, push cur_pair to group
-				if(grouping_crit)
+				if( group_accepts(groups_out[*g], bounds[*g], cur_pair, target, ligand, t_pos, l_pos) )
 				{
-					grp->push_back( cur_pair );
+					groups_out[*g].push_back( cur_pair );
+					box_extend(bounds[*g].target, t_pos);
+					box_extend(bounds[*g].ligand, l_pos);
+					groups_near.insert(t_pos, *g);
 					added = true;
 				}
 			}
@@ -145,11 +266,15 @@ void Docker::build_matching_groups(const SurfaceDescriptors& desc_target,
 				MatchingGroup new_group;
 				new_group.push_back( cur_pair );
 				groups_out.push_back( new_group );
+
+				bounds.push_back( (GroupBounds){ box_around(t_pos), box_around(l_pos) } );
+				seen.push_back(-1);
+				groups_near.insert(t_pos, groups_out.size() - 1);
 			}
 		}
 	}
 
-	return;
+	return true;
 }
 
 // This function builds the transformations that aligns each of the
@@ -159,61 +284,13 @@ void Docker::transformations_from_matching_groups(const std::vector<MatchingGrou
 												const Graph& ligand, const SurfaceDescriptors& desc_ligand,
 												std::vector<glm::dmat4>& mg_transformation) const
 {
-	// TODO: For future work, after translating and aligning we'll use
-	// ICP with Regular Grid to get a better alignment for the clouds.
-	
-	for(auto MG = matching_groups.begin(); MG != matching_groups.end(); ++MG)
-	{
-		//0) Split matching group pairs into two vectors
-		std::vector<int> target_groups, ligand_groups;
-		for(auto p = MG->begin(); p != MG->end(); ++p)
-		{
-			target_groups.push_back( p->first );
-			ligand_groups.push_back( p->second );
-		}
-
-		//1) Merge patches from TARGET group
-		std::vector<glm::dvec3> target_cloud; glm::dvec3 target_normal;
-		build_cloud_from_group(target_groups, desc_target, target, target_cloud, target_normal);
-
-		//2) Merge patches from LIGAND group
-		std::vector<glm::dvec3> ligand_cloud; glm::dvec3 ligand_normal;
-		build_cloud_from_group(ligand_groups, desc_ligand, ligand, ligand_cloud, ligand_normal);
-
-		//3) Compute centroids of each patch
-		glm::dvec3 target_centroid = cloud_centroid(target_cloud);
-		glm::dvec3 ligand_centroid = cloud_centroid(ligand_cloud);
-
-		//4) Compute rotation that aligns the average normal of the patches.
-		//	To accomplish this, the cross product between the two vectors gives us the
-		//	axle of rotation and the dot product gives us the angle. We build
-		//	a quaternion that rotates the first vector so to align it with the
-		//	second one, then we get the 4x4 rotation matrix which is equivalent
-		//	to this quaternion. Remember we need to rotate it around the centroid so not
-		//  to translate it and change distances!
-		//TODO: ROTATION IS NOT LINEAR IN THE END! DEFORMATION IS HAPPENING -> Rodrigues' formula?
-		//TODO: Border cases: vectors form an angle of 0°, 180°?
-
-		glm::dvec3 rot_axle = glm::cross(ligand_normal, target_normal);
-
-		double rot_angle = (glm::acos(glm::dot(ligand_normal, target_normal)) + glm::pi<double>()) / 2.0;
-		double rot_cos = glm::cos(rot_angle), rot_sin = glm::sin(rot_angle);
-
-		glm::dquat quat_align_normals = glm::dquat(rot_cos,
-												rot_axle.x * rot_sin, 
-												rot_axle.y * rot_sin,
-												rot_axle.z * rot_sin);
-
-		glm::dmat4 align_normals = glm::mat4_cast(quat_align_normals);
-
-		//5) Compose final transformation:
-		//		send to origin, rotate, bring back to target centroid
-		glm::dmat4 final_t = glm::translate(glm::dmat4(1.0), target_centroid) 
-								* align_normals
-								* glm::translate(glm::dmat4(1.0), -ligand_centroid);
-
-		mg_transformation.push_back( final_t );
-	}
-
-	return;
+	//groups are independent: each one fills its own slot
+	size_t first = mg_transformation.size();
+	mg_transformation.resize( first + matching_groups.size() );
+
+	parallel_for(0, matching_groups.size(), [&matching_groups, &target, &desc_target, &ligand, &desc_ligand,
+											  &mg_transformation, first](int begin, int end, int) {
+		for(int i = begin; i < end; i++)
+			mg_transformation[first + i] = align_group(matching_groups[i], target, desc_target, ligand, desc_ligand);
+	});
 }
\ No newline at end of file
@@ -0,0 +1,218 @@
+#include "../../inc/docker/fft_docker.h"
+#include "../../inc/math/fft.h"
+#include "../../inc/math/linalg.h"
+#include "../../inc/util/parallel.h"
+#include "../../inc/util/topk.h"
+#include "../../inc/parameters.h"
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/constants.hpp>
+#include <complex>
+#include <limits>
+#include <algorithm>
+
+//------------------------------------------------------
+//--------------------- INTERNAL -----------------------
+//------------------------------------------------------
+typedef std::complex<double> Complex;
+
+//Translations kept for each rotation
+static const int PEAKS_PER_ROTATION = 3;
+
+//A translation of the ligand: (correlation, node of its centre)
+typedef std::pair<double, int> Peak;
+
+//Best correlation first, then first node
+struct BetterPeak
+{
+	bool operator()(const Peak& lhs, const Peak& rhs) const
+	{
+		if(lhs.first != rhs.first) return lhs.first > rhs.first;
+		return lhs.second < rhs.second;
+	}
+};
+
+typedef struct {
+	Peak peak;
+	int rotation;
+} Candidate;
+
+static bool better_candidate(const Candidate& lhs, const Candidate& rhs)
+{
+	if(lhs.peak.first != rhs.peak.first) return lhs.peak.first > rhs.peak.first;
+	if(lhs.rotation != rhs.rotation) return lhs.rotation < rhs.rotation;
+	return lhs.peak.second < rhs.peak.second;
+}
+
+//Value of a receptor node, from the receptor grid sampled there
+static double receptor_value(const GridSample& g)
+{
+	if(g.distance < -Parameters::CLASH_DEPTH) return g.occupancy >= 0.5f ? -Parameters::CLASH_PENALTY : 0.0;
+	if(g.distance <= Parameters::CONTACT_DIST) return 1.0;
+	return 0.0;
+}
+
+//------------------------------------------------------
+//------------------- FROM FFT_DOCKER.H ----------------
+//------------------------------------------------------
+FFTDocker::FFTDocker(const Graph& receptor, const Scoring& scoring)
+	: receptor(receptor), scoring(scoring) { }
+
+void FFTDocker::rotation_set(int n, std::vector<glm::dmat3>& rotations)
+{
+	//Alexa, "Super-Fibonacci spirals" (CVPR 2022)
+	const double phi = sqrt(2.0), psi = 1.533751168755204288118041;
+	const double two_pi = 2.0 * glm::pi<double>();
+
+	rotations.clear();
+	for(int i = 0; i < n; i++)
+	{
+		double s = i + 0.5;
+		double r = sqrt(s / n), R = sqrt(1.0 - s / n);
+		double alpha = two_pi * s / phi, beta = two_pi * s / psi;
+
+		glm::dquat q(R * cos(beta), r * sin(alpha), r * cos(alpha), R * sin(beta));
+		rotations.push_back( glm::mat3_cast(q) );
+	}
+}
+
+void FFTDocker::correlate(const FFTPlan& plan, const std::vector<Complex>& rec,
+						  const ReceptorGrid& ligand_grid, const glm::dvec3& center, int reach,
+						  const glm::dmat3* rotations, int count, std::vector<Complex>& lig)
+{
+	const int n = plan.size();
+	const size_t sy = n, sz = (size_t)n*n, total = (size_t)n*n*n;
+	const double spacing = Parameters::FFT_SPACING;
+
+	lig.assign(total, Complex(0.0));
+	for(int r = 0; r < count; r++)
+	{
+		//rotating the ligand by R is sampling it rotated by R^-1
+		const glm::dmat3 inv = glm::transpose(rotations[r]);
+		const Complex one = r == 0 ? Complex(1.0, 0.0) : Complex(0.0, 1.0);
+
+		for(int z = -reach; z <= reach; z++)
+		for(int y = -reach; y <= reach; y++)
+		for(int x = -reach; x <= reach; x++)
+		{
+			GridSample g = ligand_grid.sample( center + inv * (glm::dvec3(x, y, z)*spacing) );
+			if(g.occupancy >= 0.5f) lig[ (x + n) % n + sy*((y + n) % n) + sz*((z + n) % n) ] += one;
+		}
+	}
+
+	plan.forward(lig.data());
+	for(size_t i = 0; i < total; i++)
+	{
+		//rec * conj(lig), without the checks of operator*
+		const Complex &a = rec[i], &b = lig[i];
+		lig[i] = Complex(a.real()*b.real() + a.imag()*b.imag(), a.imag()*b.real() - a.real()*b.imag());
+	}
+	plan.inverse(lig.data());
+}
+
+void FFTDocker::dock(const Graph& ligand, std::vector<FFTPose>& poses) const
+{
+	poses.clear();
+
+	const ReceptorGrid& receptor_grid = scoring.get_grid();
+	const double spacing = Parameters::FFT_SPACING;
+	if(receptor_grid.empty() || ligand.size() == 0 || spacing <= 0.0 || Parameters::FFT_ROTATIONS <= 0) return;
+
+	//the ligand is rotated about its centroid; RADIUS bounds it
+	ConstSpan<glm::dvec3> lig_positions = ligand.get_positions();
+	glm::dvec3 lig_center = cloud_centroid(lig_positions);
+	double radius = 0.0;
+	for(auto p = lig_positions.begin(); p != lig_positions.end(); ++p)
+		radius = std::max(radius, glm::length(*p - lig_center));
+
+	//ligand occupancy is sampled from a grid of its own, rotated
+	ReceptorGrid ligand_grid;
+	ligand_grid.build(ligand, receptor_grid.get_spacing(), receptor_grid.get_band());
+
+	//the FFT grid holds the receptor with room for the ligand all
+	//around it, so that correlations never wrap around
+	ConstSpan<glm::dvec3> rec_positions = receptor.get_positions();
+	glm::dvec3 lo = rec_positions[0], hi = rec_positions[0];
+	for(auto p = rec_positions.begin(); p != rec_positions.end(); ++p)
+	{
+		lo = glm::min(lo, *p);
+		hi = glm::max(hi, *p);
+	}
+
+	glm::dvec3 extent = hi - lo;
+	double width = std::max(extent.x, std::max(extent.y, extent.z)) + 2.0*(radius + receptor_grid.get_band() + spacing);
+	const int n = next_fft_size( (int)ceil(width / spacing) + 1 );
+	const size_t sy = n, sz = (size_t)n*n, total = (size_t)n*n*n;
+	const glm::dvec3 origin = 0.5*(lo + hi) - glm::dvec3(0.5*n*spacing);
+
+	FFTPlan plan(n);
+
+	//receptor grid, transformed once
+	std::vector<Complex> rec(total);
+	parallel_for(0, n, [&receptor_grid, &rec, &origin, spacing, n, sy, sz](int z_begin, int z_end, int) {
+		for(int z = z_begin; z < z_end; z++)
+		for(int y = 0; y < n; y++)
+		for(int x = 0; x < n; x++)
+			rec[x + sy*y + sz*z] = receptor_value( receptor_grid.sample(origin + glm::dvec3(x, y, z)*spacing) );
+	});
+	plan.forward(rec.data());
+
+	//for every rotation, the correlation of the receptor with the
+	//ligand centred at each node: IFFT( REC * conj(LIG) ), where node
+	//(x,y,z) of LIG holds the rotated ligand at offset (x,y,z) from its
+	//centre (wrapping around). Both grids are real, so rotations go in
+	//pairs: with the first ligand as the real part of LIG and the second
+	//as the imaginary part, the result is the first correlation minus i
+	//times the second, for the price of one.
+	std::vector<glm::dmat3> rotations;
+	rotation_set(Parameters::FFT_ROTATIONS, rotations);
+
+	const int n_rotations = rotations.size();
+	const int reach = std::min( (int)ceil(radius / spacing) + 1, n / 2 - 1 );
+	std::vector<Peak> peaks( n_rotations * PEAKS_PER_ROTATION, Peak(0.0, -1) );
+
+	parallel_for(0, (n_rotations + 1) / 2, [&plan, &rotations, &ligand_grid, &lig_center, &rec, &peaks,
+											 n_rotations, reach, total](int begin, int end, int) {
+		std::vector<Complex> lig(total);
+		TopK<Peak, BetterPeak> best;
+		std::vector<Peak> sorted;
+
+		for(int pair = begin; pair < end; pair++)
+		{
+			int first = 2*pair, count = std::min(2, n_rotations - first);
+
+			correlate(plan, rec, ligand_grid, lig_center, reach, &rotations[first], count, lig);
+
+			for(int r = 0; r < count; r++)
+			{
+				best.reset(PEAKS_PER_ROTATION);
+				for(size_t i = 0; i < total; i++) best.push( Peak(r == 0 ? lig[i].real() : -lig[i].imag(), i) );
+
+				best.sorted(sorted);
+				std::copy(sorted.begin(), sorted.end(), peaks.begin() + (first + r)*PEAKS_PER_ROTATION);
+			}
+		}
+	});
+
+	//best poses over all rotations
+	std::vector<Candidate> candidates;
+	for(unsigned int i = 0; i < peaks.size(); i++)
+		if(peaks[i].second >= 0) candidates.push_back( (Candidate){ peaks[i], (int)(i / PEAKS_PER_ROTATION) } );
+
+	std::sort(candidates.begin(), candidates.end(), better_candidate);
+	if( (int)candidates.size() > Parameters::N_BEST_POSES ) candidates.resize( std::max(Parameters::N_BEST_POSES, 0) );
+
+	for(unsigned int i = 0; i < candidates.size(); i++)
+	{
+		const glm::dmat3& R = rotations[ candidates[i].rotation ];
+		int node = candidates[i].peak.second;
+		glm::dvec3 center = origin + glm::dvec3(node % n, (node / n) % n, node / (n*n)) * spacing;
+
+		//rotate about the ligand centre, then move it to CENTER
+		glm::dmat4 T(R);
+		T[3] = glm::dvec4(center - R * lig_center, 1.0);
+
+		FFTPose pose = { T, candidates[i].peak.first, candidates[i].rotation, scoring.score(ligand, T) };
+		pose.score.pose = i;
+		poses.push_back(pose);
+	}
+}
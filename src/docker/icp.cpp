@@ -0,0 +1,169 @@
+#include "../../inc/docker/icp.h"
+#include "../../inc/math/simd_kernels.h"
+#include "../../inc/math/linalg.h"
+#include "../../inc/util/parallel.h"
+#include "../../inc/parameters.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <chrono>
+#include <algorithm>
+
+//------------------------------------------------------
+//--------------------- INTERNAL -----------------------
+//------------------------------------------------------
+//Motions whose eigenvalue in the normal equations is below this fraction
+//of the largest one are taken as unconstrained by the pairs
+static const double MIN_EIGEN_RATIO = 1e-3;
+
+//Nodes of the ligand patches of a matching group, each one once
+static void group_nodes(const MatchingGroup& group, const SurfaceDescriptors& desc_ligand, std::vector<int>& nodes)
+{
+	nodes.clear();
+	for(auto pair = group.begin(); pair != group.end(); ++pair)
+	{
+		const Patch& patch = desc_ligand[pair->second].first;
+		nodes.insert(nodes.end(), patch.nodes.begin(), patch.nodes.end());
+	}
+
+	std::sort(nodes.begin(), nodes.end());
+	nodes.erase( std::unique(nodes.begin(), nodes.end()), nodes.end() );
+}
+
+//------------------------------------------------------
+//---------------------- FROM ICP.H --------------------
+//------------------------------------------------------
+ICP::ICP(const Graph& target) : target(target), tree(target.get_positions()) { }
+
+ICPResult ICP::refine(const Graph& ligand, const std::vector<int>& nodes, const glm::dmat4& start) const
+{
+	std::chrono::steady_clock::time_point clock_start = std::chrono::steady_clock::now();
+	ICPResult res = { start, 0, false, 0, 0.0, 0.0 };
+
+	//the cloud is gathered once; every iteration moves all of it with
+	//the batched transform kernel
+	int count = nodes.size();
+	std::vector<glm::dvec3> cloud(2*count), moved(2*count);	//positions, then normals
+	for(int k = 0; k < count; k++)
+	{
+		cloud[k] = ligand.get_pos(nodes[k]);
+		cloud[count + k] = ligand.get_normal(nodes[k]);
+	}
+
+	glm::dmat4 T = start;
+	for(int it = 0; it < Parameters::ICP_MAX_ITERATIONS && count > 0; it++)
+	{
+		transform_points(&cloud[0].x, &cloud[count].x, 0, count, &T[0][0], 1, &moved[0].x, &moved[count].x);
+
+		//the update rotates about the centroid of the moved cloud,
+		//which keeps the system well conditioned
+		glm::dvec3 c(0.0);
+		for(int k = 0; k < count; k++) c += moved[k];
+		c /= (double)count;
+
+		//normal equations of min sum( (w x (p - c) + d + p - q) . n )²
+		//over the rotation vector w and the translation d
+		double ata[6][6] = {{0.0}}, atb[6] = {0.0};
+		double err = 0.0;
+		int pairs = 0;
+
+		for(int k = 0; k < count; k++)
+		{
+			const glm::dvec3 &p = moved[k], &m = moved[count + k];
+
+			double dist2;
+			int q = tree.nearest(p, Parameters::ICP_MAX_DIST, dist2);
+			if(q < 0) continue;
+
+			const glm::dvec3& n = target.get_normal(q);
+			if(glm::dot(m, n) > 0.0) continue;
+
+			glm::dvec3 arm = glm::cross(p - c, n);
+			double a[6] = { arm.x, arm.y, arm.z, n.x, n.y, n.z };
+			double b = glm::dot(target.get_pos(q) - p, n);
+
+			for(int r = 0; r < 6; r++)
+			{
+				for(int s = 0; s <= r; s++) ata[r][s] += a[r] * a[s];
+				atb[r] += a[r] * b;
+			}
+
+			err += b*b;
+			pairs++;
+		}
+
+		res.pairs = pairs;
+		res.rms = pairs > 0 ? sqrt(err / pairs) : 0.0;
+		if(pairs < 6) break;
+
+		//a flat or symmetric cloud leaves some motions unconstrained (a
+		//spherical cap slides freely about its centre): the system is
+		//solved in its eigenbasis and those motions are left out instead
+		//of amplifying noise. Rotations are scaled by the spread of the
+		//cloud first, so that both halves are measured alike.
+		double rot_trace = 0.0;
+		for(int r = 0; r < 6; r++)
+			for(int s = 0; s < r; s++) ata[s][r] = ata[r][s];
+		for(int r = 0; r < 3; r++) rot_trace += ata[r][r];
+
+		double scale[6] = { 1.0, 1.0, 1.0, 1.0, 1.0, 1.0 };
+		if(rot_trace > 0.0) scale[0] = scale[1] = scale[2] = sqrt(pairs / rot_trace);
+
+		for(int r = 0; r < 6; r++)
+		{
+			for(int s = 0; s < 6; s++) ata[r][s] *= scale[r] * scale[s];
+			atb[r] *= scale[r];
+		}
+
+		double eval[6], evec[6][6];
+		symmetric_eigen<6>(ata, eval, evec);
+
+		double max_eval = *std::max_element(eval, eval + 6);
+		double x[6] = { 0.0 };
+		for(int k = 0; k < 6; k++)
+		{
+			if( !(eval[k] > MIN_EIGEN_RATIO * max_eval) ) continue;
+
+			double proj = 0.0;
+			for(int r = 0; r < 6; r++) proj += evec[r][k] * atb[r];
+			for(int r = 0; r < 6; r++) x[r] += evec[r][k] * proj / eval[k];
+		}
+		for(int r = 0; r < 6; r++) x[r] *= scale[r];
+
+		glm::dvec3 w(x[0], x[1], x[2]), d(x[3], x[4], x[5]);
+		double angle = glm::length(w);
+
+		glm::dmat4 rot(1.0);
+		if(angle > 0.0) rot = glm::rotate(glm::dmat4(1.0), angle, w / angle);
+
+		T = glm::translate(glm::dmat4(1.0), c + d) * rot * glm::translate(glm::dmat4(1.0), -c) * T;
+		res.iterations = it + 1;
+
+		if(angle < Parameters::ICP_TOLERANCE && glm::length(d) < Parameters::ICP_TOLERANCE)
+		{
+			res.converged = true;
+			break;
+		}
+	}
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - clock_start;
+	res.transform = T;
+	res.seconds = elapsed.count();
+	return res;
+}
+
+void ICP::refine_groups(const std::vector<MatchingGroup>& groups,
+						const Graph& ligand, const SurfaceDescriptors& desc_ligand,
+						std::vector<glm::dmat4>& transformations,
+						std::vector<ICPResult>& results) const
+{
+	results.resize( transformations.size() );
+
+	parallel_for(0, transformations.size(), [this, &groups, &ligand, &desc_ligand, &transformations, &results](int begin, int end, int) {
+		std::vector<int> nodes;
+		for(int i = begin; i < end; i++)
+		{
+			group_nodes(groups[i], desc_ligand, nodes);
+			results[i] = refine(ligand, nodes, transformations[i]);
+			transformations[i] = results[i].transform;
+		}
+	});
+}
@@ -0,0 +1,298 @@
+#include "../../inc/docker/receptor_grid.h"
+#include "../../inc/util/parallel.h"
+#include "../../inc/util/checksum.h"
+#include <unistd.h>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <atomic>
+#include <fstream>
+#include <algorithm>
+
+//------------------------------------------------------
+//--------------------- INTERNAL -----------------------
+//------------------------------------------------------
+// Layout of a grid cache file (all values in host byte order):
+//
+//	GridHeader
+//	distance		n_nodes		x float
+//	occupancy		n_nodes		x float
+//	normals			n_nodes		x 3 floats
+//
+// The checksum covers everything after the header.
+static const char GRID_MAGIC[8] = { 'S', 'P', 'D', 'O', 'C', 'K', 'G', '\0' };
+static const uint32_t GRID_VERSION = 1;
+
+typedef struct {
+	char magic[8];
+	uint32_t version;
+	uint32_t header_size;
+	uint64_t payload_size;
+	uint64_t checksum;
+
+	//what the grids were built from
+	uint64_t source;
+	double spacing, band;
+
+	double origin[3];
+	int32_t dims[3];
+	uint32_t pad;
+} GridHeader;
+
+static_assert(sizeof(GridHeader) % 8 == 0, "grids must stay 8-byte aligned");
+
+//Identifies a receptor by its positions and normals
+static uint64_t receptor_hash(const Graph& receptor)
+{
+	ConstSpan<glm::dvec3> positions = receptor.get_positions();
+	ConstSpan<glm::dvec3> normals = receptor.get_normals();
+
+	uint64_t h = checksum(reinterpret_cast<const char*>(positions.data()), positions.size()*sizeof(glm::dvec3));
+	return h * 0x9E3779B185EBCA87ULL ^ checksum(reinterpret_cast<const char*>(normals.data()), normals.size()*sizeof(glm::dvec3));
+}
+
+//------------------------------------------------------
+//------------------- FROM RECEPTOR_GRID.H -------------
+//------------------------------------------------------
+ReceptorGrid::ReceptorGrid() : origin(0.0), spacing(1.0), band(0.0), source(0),
+							   distance(NULL), occupancy(NULL), normals(NULL)
+{
+	dims[0] = dims[1] = dims[2] = 0;
+}
+
+void ReceptorGrid::clear()
+{
+	dims[0] = dims[1] = dims[2] = 0;
+	distance = occupancy = normals = NULL;
+	storage.clear();
+	file.close();
+}
+
+void ReceptorGrid::build(const Graph& receptor, double spacing, double band)
+{
+	clear();
+	this->spacing = spacing;
+	this->band = band;
+	this->source = receptor_hash(receptor);
+
+	ConstSpan<glm::dvec3> positions = receptor.get_positions();
+	ConstSpan<glm::dvec3> surface_normals = receptor.get_normals();
+	if(positions.empty() || spacing <= 0.0 || band <= 0.0) return;
+
+	//bounding box of the surface, with a margin wider than BAND,
+	//so that the nodes on the border of the grid are all far from it
+	glm::dvec3 lo = positions[0], hi = positions[0];
+	for(auto p = positions.begin(); p != positions.end(); ++p)
+	{
+		lo = glm::min(lo, *p);
+		hi = glm::max(hi, *p);
+	}
+
+	double margin = band + spacing;
+	origin = lo - glm::dvec3(margin);
+	for(int k = 0; k < 3; k++) dims[k] = (int)ceil( (hi[k] - lo[k] + 2.0*margin) / spacing ) + 1;
+
+	const int nx = dims[0], ny = dims[1], nz = dims[2];
+	const size_t n = n_nodes();
+	const int reach = (int)ceil(band / spacing);
+
+	//distance to the nearest surface point within BAND of every node.
+	//Each chunk owns a slab of z-layers, and goes over every point.
+	std::vector<double> near_dist(n, std::numeric_limits<double>::infinity());
+	std::vector<int> nearest(n, -1);
+
+	parallel_for(0, nz, [this, &positions, &near_dist, &nearest, nx, ny, reach, spacing, band](int z_begin, int z_end, int) {
+		for(unsigned int v = 0; v < positions.size(); v++)
+		{
+			const glm::dvec3& p = positions[v];
+			glm::dvec3 g = (p - origin) / spacing;
+			int ci = (int)floor(g.x + 0.5), cj = (int)floor(g.y + 0.5), ck = (int)floor(g.z + 0.5);
+
+			int k0 = std::max(ck - reach, z_begin), k1 = std::min(ck + reach, z_end - 1);
+			int j0 = std::max(cj - reach, 0), j1 = std::min(cj + reach, ny - 1);
+			int i0 = std::max(ci - reach, 0), i1 = std::min(ci + reach, nx - 1);
+
+			for(int k = k0; k <= k1; k++)
+			for(int j = j0; j <= j1; j++)
+			for(int i = i0; i <= i1; i++)
+			{
+				size_t idx = i + nx*(j + (size_t)ny*k);
+				double d = glm::length(origin + glm::dvec3(i, j, k)*spacing - p);
+
+				if(d <= band && d < near_dist[idx])
+				{
+					near_dist[idx] = d;
+					nearest[idx] = v;
+				}
+			}
+		}
+	});
+
+	//nodes far from the surface which are connected to node (0,0,0),
+	//on the border, through other far nodes (6-connectivity) are outside
+	std::vector<char> outside(n, 0);
+	std::vector<size_t> stack(1, 0);
+	outside[0] = 1;
+
+	while(!stack.empty())
+	{
+		size_t idx = stack.back(); stack.pop_back();
+		int i = idx % nx, j = (idx / nx) % ny, k = idx / ((size_t)nx*ny);
+
+		size_t ngbrs[6]; int m = 0;
+		if(i > 0) ngbrs[m++] = idx - 1;
+		if(i < nx - 1) ngbrs[m++] = idx + 1;
+		if(j > 0) ngbrs[m++] = idx - nx;
+		if(j < ny - 1) ngbrs[m++] = idx + nx;
+		if(k > 0) ngbrs[m++] = idx - (size_t)nx*ny;
+		if(k < nz - 1) ngbrs[m++] = idx + (size_t)nx*ny;
+
+		for(int e = 0; e < m; e++)
+		{
+			if(outside[ngbrs[e]] || nearest[ngbrs[e]] >= 0) continue;
+			outside[ngbrs[e]] = 1;
+			stack.push_back(ngbrs[e]);
+		}
+	}
+
+	//fill the grids
+	storage.assign(5*n, 0.0f);
+	float *dist = storage.data(), *occ = dist + n, *nrm = occ + n;
+
+	parallel_for(0, nz, [this, &positions, &surface_normals, &near_dist, &nearest, &outside,
+						 dist, occ, nrm, nx, ny, spacing, band](int z_begin, int z_end, int) {
+		for(int k = z_begin; k < z_end; k++)
+		for(int j = 0; j < ny; j++)
+		for(int i = 0; i < nx; i++)
+		{
+			size_t idx = i + nx*(j + (size_t)ny*k);
+			int v = nearest[idx];
+
+			if(v < 0)
+			{
+				dist[idx] = outside[idx] ? band : -band;
+				occ[idx] = outside[idx] ? 0.0f : 1.0f;
+				continue;
+			}
+
+			glm::dvec3 node = origin + glm::dvec3(i, j, k)*spacing;
+			bool inside = glm::dot(node - positions[v], surface_normals[v]) < 0.0;
+
+			dist[idx] = inside ? -near_dist[idx] : near_dist[idx];
+			occ[idx] = inside ? 1.0f : 0.0f;
+			for(int c = 0; c < 3; c++) nrm[3*idx + c] = surface_normals[v][c];
+		}
+	});
+
+	distance = dist; occupancy = occ; normals = nrm;
+}
+
+bool ReceptorGrid::save(const std::string& path) const
+{
+	if(empty()) return false;
+
+	GridHeader h;
+	memset(&h, 0, sizeof(GridHeader));
+	memcpy(h.magic, GRID_MAGIC, sizeof(GRID_MAGIC));
+	h.version = GRID_VERSION;
+	h.header_size = sizeof(GridHeader);
+	h.source = source;
+	h.spacing = spacing;
+	h.band = band;
+	for(int k = 0; k < 3; k++) { h.origin[k] = origin[k]; h.dims[k] = dims[k]; }
+
+	//the three grids are contiguous, wherever they live
+	const char* payload = reinterpret_cast<const char*>(distance);
+	h.payload_size = 5*n_nodes()*sizeof(float);
+	h.checksum = checksum(payload, h.payload_size);
+
+	//write to a temporary file and rename it, so readers never
+	//see a half-written grid (same as the surface cache)
+	static std::atomic<unsigned int> n_writes(0);
+	std::string tmp = path + ".tmp." + std::to_string(getpid()) + "." + std::to_string(n_writes++);
+	std::fstream out;
+	out.open(tmp, std::fstream::out | std::fstream::binary | std::fstream::trunc);
+	if(!out.is_open()) return false;
+
+	out.write(reinterpret_cast<const char*>(&h), sizeof(GridHeader));
+	out.write(payload, h.payload_size);
+	out.close();
+
+	if(out.fail() || rename(tmp.c_str(), path.c_str()) != 0)
+	{
+		remove(tmp.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+bool ReceptorGrid::load(const std::string& path, const Graph& receptor, double spacing, double band)
+{
+	clear();
+
+	if(!file.open(path)) return false;
+
+	GridHeader h;
+	bool ok = file.size() >= sizeof(GridHeader);
+	if(ok) memcpy(&h, file.begin(), sizeof(GridHeader));
+
+	//check format and freshness
+	ok = ok && memcmp(h.magic, GRID_MAGIC, sizeof(GRID_MAGIC)) == 0;
+	ok = ok && h.version == GRID_VERSION && h.header_size == sizeof(GridHeader);
+	ok = ok && h.spacing == spacing && h.band == band;
+	ok = ok && h.dims[0] > 0 && h.dims[1] > 0 && h.dims[2] > 0;
+	ok = ok && h.payload_size == 5 * (uint64_t)h.dims[0] * h.dims[1] * h.dims[2] * sizeof(float);
+	ok = ok && h.payload_size == file.size() - sizeof(GridHeader);
+	ok = ok && h.source == receptor_hash(receptor);
+	ok = ok && checksum(file.begin() + sizeof(GridHeader), h.payload_size) == h.checksum;
+
+	if(!ok) { clear(); return false; }
+
+	this->spacing = spacing;
+	this->band = band;
+	this->source = h.source;
+	origin = glm::dvec3(h.origin[0], h.origin[1], h.origin[2]);
+	for(int k = 0; k < 3; k++) dims[k] = h.dims[k];
+
+	//the payload follows the 8-byte aligned header in a page-aligned
+	//mapping, so the floats are read in place
+	size_t n = n_nodes();
+	distance = reinterpret_cast<const float*>(file.begin() + sizeof(GridHeader));
+	occupancy = distance + n;
+	normals = occupancy + n;
+
+	return true;
+}
+
+GridSample ReceptorGrid::sample(const glm::dvec3& p) const
+{
+	GridSample s = { (float)band, 0.0f, glm::vec3(0.0f) };
+
+	//the nodes on the border of the grid are all far outside, so
+	//(as NaN coordinates) anything beyond them is too
+	glm::dvec3 g = (p - origin) / spacing;
+	if( !(g.x >= 0.0 && g.y >= 0.0 && g.z >= 0.0 &&
+		  g.x < dims[0] - 1 && g.y < dims[1] - 1 && g.z < dims[2] - 1) ) return s;
+
+	int i = (int)g.x, j = (int)g.y, k = (int)g.z;
+	double fx = g.x - i, fy = g.y - j, fz = g.z - k;
+
+	const size_t sy = dims[0], sz = (size_t)dims[0]*dims[1];
+	const size_t base = i + sy*j + sz*k;
+
+	s.distance = 0.0f;
+	for(int c = 0; c < 8; c++)
+	{
+		int dx = c & 1, dy = (c >> 1) & 1, dz = c >> 2;
+		float w = (dx ? fx : 1.0 - fx) * (dy ? fy : 1.0 - fy) * (dz ? fz : 1.0 - fz);
+		size_t idx = base + dx + sy*dy + sz*dz;
+
+		s.distance += w * distance[idx];
+		s.occupancy += w * occupancy[idx];
+		s.normal += w * glm::vec3(normals[3*idx], normals[3*idx + 1], normals[3*idx + 2]);
+	}
+
+	return s;
+}
@@ -0,0 +1,115 @@
+#include "../../inc/docker/scoring.h"
+#include "../../inc/graph/transformed_view.h"
+#include "../../inc/util/parallel.h"
+#include "../../inc/parameters.h"
+#include <algorithm>
+
+#include <iostream>
+
+//------------------------------------------------------
+//--------------------- INTERNAL -----------------------
+//------------------------------------------------------
+//Best score first, then first pose
+static bool better_pose(const PoseScore& lhs, const PoseScore& rhs)
+{
+	if(lhs.score != rhs.score) return lhs.score > rhs.score;
+	return lhs.pose < rhs.pose;
+}
+
+//Ligand nodes transformed at a time, and poses transformed together by
+//rank(): a block of every pose (positions and normals, 96 KB) stays in L2
+static const int SCORE_BLOCK = 128;
+static const int RANK_POSES = 16;
+
+//Adds the contacts and clashes of N transformed ligand nodes to S
+static void accumulate(const ReceptorGrid& grid, const glm::dvec3* positions, const glm::dvec3* normals,
+					   int n, PoseScore& s)
+{
+	for(int i = 0; i < n; i++)
+	{
+		GridSample g = grid.sample( positions[i] );
+
+		if(g.distance < -Parameters::CLASH_DEPTH)
+		{
+			//deep inside, unless the distance was clamped outside
+			if(g.occupancy >= 0.5f) s.clashes++;
+		}
+		else if(g.distance <= Parameters::CONTACT_DIST)
+		{
+			if( glm::dot(normals[i], glm::dvec3(g.normal)) < 0.0 ) s.contacts++;
+		}
+	}
+}
+
+//------------------------------------------------------
+//-------------------- FROM SCORING.H ------------------
+//------------------------------------------------------
+Scoring::Scoring(const Graph& receptor, const std::string& grid_cache)
+{
+	//distances are only needed as far as the thresholds, plus
+	//a node so that samples near them aren't clamped
+	double spacing = Parameters::GRID_SPACING;
+	double band = std::max(Parameters::CONTACT_DIST, Parameters::CLASH_DEPTH) + spacing;
+
+	if( !grid_cache.empty() && grid.load(grid_cache, receptor, spacing, band) ) return;
+
+	grid.build(receptor, spacing, band);
+
+	//as with surface caches, we'll just build the grid again next time
+	if( !grid_cache.empty() && !grid.save(grid_cache) )
+		std::cerr<<"Could not write receptor grid "<<grid_cache<<std::endl;
+}
+
+PoseScore Scoring::score(const Graph& ligand, const glm::dmat4& T) const
+{
+	PoseScore s = { 0, 0.0, 0, 0 };
+
+	//the ligand is never moved: its nodes are transformed a block at a
+	//time into scratch buffers on the stack
+	TransformedView moved(ligand, T);
+	glm::dvec3 positions[SCORE_BLOCK], normals[SCORE_BLOCK];
+
+	int n = moved.size();
+	for(int b = 0; b < n; b += SCORE_BLOCK)
+	{
+		int e = std::min(b + SCORE_BLOCK, n);
+		moved.transform(b, e, positions, normals);
+		accumulate(grid, positions, normals, e - b, s);
+	}
+
+	s.score = s.contacts - Parameters::CLASH_PENALTY * s.clashes;
+	return s;
+}
+
+void Scoring::rank(const Graph& ligand, const std::vector<glm::dmat4>& poses,
+				   std::vector<PoseScore>& ranked) const
+{
+	ranked.resize( poses.size() );
+
+	//poses go RANK_POSES at a time through the ligand, so each block of
+	//it is read once for all of them. Same sums as score(), in the same order.
+	parallel_for(0, poses.size(), [this, &ligand, &poses, &ranked](int begin, int end, int) {
+		std::vector<glm::dvec3> positions(RANK_POSES * SCORE_BLOCK), normals(RANK_POSES * SCORE_BLOCK);
+		int n = ligand.size();
+
+		for(int first = begin; first < end; first += RANK_POSES)
+		{
+			int k = std::min(RANK_POSES, end - first);
+			for(int j = 0; j < k; j++)
+				ranked[first + j] = (PoseScore){ first + j, 0.0, 0, 0 };
+
+			for(int b = 0; b < n; b += SCORE_BLOCK)
+			{
+				int e = std::min(b + SCORE_BLOCK, n);
+				TransformedView::transform_poses(ligand, &poses[first], k, b, e, &positions[0], &normals[0]);
+				for(int j = 0; j < k; j++)
+					accumulate(grid, &positions[j*(e - b)], &normals[j*(e - b)], e - b, ranked[first + j]);
+			}
+
+			for(int j = 0; j < k; j++)
+				ranked[first + j].score = ranked[first + j].contacts - Parameters::CLASH_PENALTY * ranked[first + j].clashes;
+		}
+	});
+
+	std::sort(ranked.begin(), ranked.end(), better_pose);
+}
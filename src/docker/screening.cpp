@@ -0,0 +1,159 @@
+#include "../../inc/docker/screening.h"
+#include "../../inc/io/fileio.h"
+#include "../../inc/util/thread_pool.h"
+#include "../../inc/parameters.h"
+#include <sys/stat.h>
+#include <cerrno>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+
+#include <iostream>
+
+//------------------------------------------------------
+//--------------------- INTERNAL -----------------------
+//------------------------------------------------------
+//File name of BASENAME without its directory
+static std::string file_name(const std::string& basename)
+{
+	size_t slash = basename.find_last_of('/');
+	return slash == std::string::npos ? basename : basename.substr(slash + 1);
+}
+
+static bool make_dir(const std::string& path)
+{
+	if( mkdir(path.c_str(), 0755) == 0 || errno == EEXIST ) return true;
+
+	std::cerr<<"Could not create output directory "<<path<<std::endl;
+	return false;
+}
+
+// Results of a ligand: a short header, then the best poses, best
+// first. Each one is the matching group it comes from (its index and
+// size, the score of its pose, how its ICP refinement went and its
+// list of (target patch, ligand patch) pairs) followed by the rows of
+// the transformation which aligns the ligand to the receptor.
+static bool write_results(const std::string& path, const std::string& ligand, int n_patches,
+						  const std::vector<MatchingGroup>& groups,
+						  const std::vector<glm::dmat4>& transformations,
+						  const std::vector<ICPResult>& refinement,
+						  const std::vector<PoseScore>& ranked)
+{
+	std::ofstream out(path.c_str());
+	if(!out) return false;
+
+	out<<std::setprecision(10);
+	out<<"# ligand "<<ligand<<"\n";
+	out<<"# patches "<<n_patches<<"\n";
+	out<<"# groups "<<groups.size()<<"\n";
+	out<<"# poses "<<ranked.size()<<"\n";
+
+	for(auto pose = ranked.begin(); pose != ranked.end(); ++pose)
+	{
+		int g = pose->pose;
+		out<<"group "<<g<<" "<<groups[g].size()<<" score "<<pose->score
+		   <<" contacts "<<pose->contacts<<" clashes "<<pose->clashes
+		   <<" icp "<<refinement[g].iterations<<" "<<refinement[g].converged<<" "<<refinement[g].rms<<"\n";
+		for(auto pair = groups[g].begin(); pair != groups[g].end(); ++pair)
+			out<<pair->first<<" "<<pair->second<<"\n";
+
+		//glm matrices are column-major: m[col][row]
+		const glm::dmat4& m = transformations[g];
+		for(int row = 0; row < 4; row++)
+			out<<m[0][row]<<" "<<m[1][row]<<" "<<m[2][row]<<" "<<m[3][row]<<"\n";
+	}
+
+	return out.good();
+}
+
+//------------------------------------------------------
+//------------------- FROM SCREENING.H -----------------
+//------------------------------------------------------
+Screening::Screening(const Graph& receptor, const SurfaceDescriptors& desc_receptor,
+					 const std::string& grid_cache)
+	: receptor(receptor), desc_receptor(desc_receptor), scoring(receptor, grid_cache), icp(receptor) { }
+
+bool Screening::read_manifest(const std::string& path, std::vector<std::string>& ligands)
+{
+	std::ifstream in(path.c_str());
+	if(!in) {
+		std::cerr<<"Could not open manifest "<<path<<std::endl;
+		return false;
+	}
+
+	std::string line;
+	while( std::getline(in, line) )
+	{
+		//trim blanks around the basename
+		size_t first = line.find_first_not_of(" \t\r");
+		if(first == std::string::npos || line[first] == '#') continue;
+
+		size_t last = line.find_last_not_of(" \t\r");
+		ligands.push_back( line.substr(first, last - first + 1) );
+	}
+
+	return true;
+}
+
+ScreeningResult Screening::dock_ligand(const std::string& basename, const std::string& out_path) const
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	ScreeningResult res = { basename, false, 0, 0, 0.0, 0.0 };
+
+	//everything but the receptor is local to this job
+	FileIO io; Docker docker;
+
+	Graph ligand; SurfaceDescriptors desc_ligand;
+	std::vector<MatchingGroup> groups;
+	if( io.surface_from_file(basename, ligand, desc_ligand) &&
+		docker.build_matching_groups(receptor, desc_receptor, ligand, desc_ligand, groups) )
+	{
+
+		std::vector<glm::dmat4> transformations;
+		docker.transformations_from_matching_groups(groups,
+													receptor, desc_receptor,
+													ligand, desc_ligand,
+													transformations);
+
+		std::vector<ICPResult> refinement;
+		icp.refine_groups(groups, ligand, desc_ligand, transformations, refinement);
+
+		//keep the best poses only
+		std::vector<PoseScore> ranked;
+		scoring.rank(ligand, transformations, ranked);
+		if( (int)ranked.size() > Parameters::N_BEST_POSES ) ranked.resize( std::max(Parameters::N_BEST_POSES, 0) );
+
+		res.n_patches = desc_ligand.size();
+		res.n_groups = groups.size();
+		res.best_score = ranked.empty() ? 0.0 : ranked[0].score;
+		res.ok = write_results(out_path, basename, res.n_patches, groups, transformations, refinement, ranked);
+
+		if(!res.ok) std::cerr<<"Could not write results file "<<out_path<<std::endl;
+	}
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	res.seconds = elapsed.count();
+	return res;
+}
+
+void Screening::run(const std::vector<std::string>& ligands, const std::string& outdir,
+					std::vector<ScreeningResult>& results) const
+{
+	if( !make_dir(outdir) ) return;
+
+	//ligands are independent jobs of very different sizes, so they go
+	//to a work-stealing pool; each job fills its own slot of the results
+	size_t first = results.size();
+	results.resize( first + ligands.size() );
+
+	ThreadPool pool( Parameters::N_THREADS );
+	for(unsigned int i = 0; i < ligands.size(); i++)
+	{
+		pool.submit( [this, &ligands, &outdir, &results, first, i]() {
+			results[first + i] = dock_ligand(ligands[i], outdir + "/" + file_name(ligands[i]) + ".dock");
+		});
+	}
+
+	pool.wait();
+}
@@ -1,15 +1,15 @@
 #include "../../inc/graph/graph.h"
 #include "../../inc/graph/patch.h"
 #include "../../inc/math/linalg.h"
+#include "../../inc/math/simd_kernels.h"
 #include "../../inc/util/unionfind.h"
+#include "../../inc/util/concurrent_unionfind.h"
+#include "../../inc/util/parallel.h"
 #include "../../inc/parameters.h"
 #include <sstream>
-#include <cstring>
-#include <set>
-#include <queue>
-#include <map>
-#include <list>
 #include <algorithm>
+#include <functional>
+#include <limits>
 
 #include <iostream>
 using std::cout;
@@ -18,198 +18,123 @@ using std::endl;
 //-------------------------------------------------------------------
 //------------------- GLOBALS, DEFINES, TYPEDEFS --------------------
 //-------------------------------------------------------------------
-static std::map<int,int> G_DISTANCES;
-static bool comp_by_distance(int rhs_node, int lhs_node) {
-	return G_DISTANCES[lhs_node] < G_DISTANCES[rhs_node];
-}
-
 #define IN_LIST 0x01
 #define VISITED 0x02
 
 //-------------------------------------------------
 //------------------- INTERNAL --------------------
 //-------------------------------------------------
-static void cluster_nodes_by_type(int current, bool visited[], const std::vector<Node>& nodes, UnionFind& UF)
+//Labels every point of REGION with its hop distance to the region's
+//contour, i.e., the points with a neighbour of a different convexity.
+//This is a single BFS seeded from all contour points at once, so it
+//costs O(V+E) for the whole region. Points which can't reach the contour
+//keep distance -1. LABEL maps each node to its region and DIST must come
+//in filled with -1 for the points of REGION; QUEUE is just scratch space.
+//
+//The search never leaves the region: any path going out of it has to
+//cross a contour point first, so the nearest contour point is always
+//reached through points of the region itself.
+static void distance_to_contour(const Graph& g, ConstSpan<int> region,
+								const std::vector<int>& label, std::vector<int>& dist,
+								std::vector<int>& queue)
 {
-	//if already visited, skip
-	if(visited[current]) return;
-
-	//retrieve current node
-	const Node& cur = nodes.at(current);
+	queue.clear();
 
-	//mark as visited
-	visited[current] = true;
-
-	//loop through all adjacent nodes and union with every
-	//one with the same convexity
-	for(int i = 0; i < cur.n_incident_faces(); i++)
+	//seed the search with the contour points
+	for(auto p = region.begin(); p != region.end(); ++p)
 	{
-		//get adjacent nodes in this face
-		const std::pair<int,int> f = cur.get_face(i);
-		const Node &f1 = nodes[f.first], &f2 = nodes[f.second];
-
-		//merge if convexity is the same
-		if( cur.get_type() == f1.get_type() )
-			UF.merge(current, f.first);
-
-		if( cur.get_type() == f2.get_type() )
-			UF.merge(current, f.second);
-
-		//recursively cluster
-		cluster_nodes_by_type(f.first, visited, nodes, UF);
-		cluster_nodes_by_type(f.second, visited, nodes, UF);
-	}
-}
+		Convexity P_type = g.get_type(*p);
 
-static void get_contour_from_cluster(const std::vector<Node>& nodes, const std::vector<int>& cluster, std::set<int>& contour)
-{
-	for(auto p = cluster.begin(); p != cluster.end(); ++p)
-	{
-		//check whether every neighbour of this point has
-		//the same convexity, i.e., is on the same region
-		//(can we prove that two adjacent points have the
-		//same convexity if and only if they lie on the
-		//same cluster?)
-		const Node &P = nodes.at(*p);
-		bool in_contour = false;
-
-		//loop through each face incident to P and check
-		//whether they lie on the same region or not
-		for(int i = 0; i < P.n_incident_faces(); i++)
+		ConstSpan<int> adj = g.neighbours(*p);
+		for(auto n = adj.begin(); n != adj.end(); ++n)
 		{
-			const Node &n1 = nodes[P.get_face(i).first];
-			const Node &n2 = nodes[P.get_face(i).second];
-
-			if(n1.get_type() != P.get_type()) in_contour = true;
-			if(n2.get_type() != P.get_type()) in_contour = true;
+			if(g.get_type(*n) != P_type)
+			{
+				dist[*p] = 0;
+				queue.push_back(*p);
+				break;
+			}
 		}
-
-		if(in_contour) contour.insert(*p);
 	}
-}
 
-static int expand_node_in_breadth(const std::vector<Node>& nodes, const std::set<int>& contour, int node)
-{
-	//unfortunatelly, visited has to be the same size as NODES
-	//because we're using the node id itself to index the table,
-	//though we'll need only contour.size() elements. I can't
-	//think of a better way to do it now, so I'll just leave it
-	//like this. TODO: change it after
-	bool *visited = new bool[nodes.size()]; 	
-	memset(visited, 0, sizeof(bool)*nodes.size());
-
-	//Pairs have form <NODE,DISTANCE>
-	std::queue<std::pair<int,int> > Q;			 
-	Q.push( std::pair<int,int>(node, 0) );
-
-	while(!Q.empty())
+	//expand in breadth from the contour towards the inside of the region
+	for(unsigned int head = 0; head < queue.size(); head++)
 	{
-		//retrieve node info
-		std::pair<int,int> cur = Q.front(); Q.pop();
-		int dist = cur.second; int id = cur.first;
-
-		//mark as visited
-		visited[id] = true;
+		int id = queue[head];
 
-		//if N is on the contour, stop and return distance
-		if( contour.count(id) > 0 ) 
+		ConstSpan<int> adj = g.neighbours(id);
+		for(auto n = adj.begin(); n != adj.end(); ++n)
 		{
-			delete[] visited;
-			return dist;
-		}
-
-		//if not, push all neighbours to queue
-		const Node& N = nodes[ id ];
-		for(int i = 0; i < N.n_incident_faces(); i++)
-		{
-			int n1 = N.get_face(i).first;
-			int n2 = N.get_face(i).second;
-
-			if( !visited[n1] )
-				Q.push( std::pair<int,int>(n1, dist+1) );
-			
-			if( !visited[n2] )
-				Q.push( std::pair<int,int>(n2, dist+1) );
+			if( label[*n] == label[id] && dist[*n] < 0 )
+			{
+				dist[*n] = dist[id] + 1;
+				queue.push_back(*n);
+			}
 		}
 	}
-
-	//if we reach this point, something went wrong (our
-	//in-breadth expansion did not reach the border ).
-	//TODO: there's a node returning -1 in test1.* dataset! Check it out -> probably it is isolated
-	return -1;
 }
 
-static Patch generate_patch(const std::vector<Node>& nodes, std::list<int>& ranked_points, int point_id)
+//Expands POINT_ID in breadth DISTANCE_FROM_BORDER times; the collected
+//points make up the patch. Every collected point is marked as consumed by
+//stamping it with REGION, so it won't be used as a seed for another patch
+//of the same region. FLAGS is scratch space of the size of the graph, which
+//must come in zeroed and is left zeroed.
+static Patch generate_patch(const Graph& g, int point_id, int distance_from_border,
+							int region, std::vector<int>& consumed, std::vector<char>& flags)
 {
-	char *visited = new char[nodes.size()]; 	
-	memset(visited, 0, sizeof(char)*nodes.size());
-
-	//this is how far we should expand this point
-	int distance_from_border = G_DISTANCES[point_id];
-
 	//push all points within the radius of this point
 	std::vector<int> patch; patch.push_back(point_id);
-							visited[point_id] |= IN_LIST;
+							flags[point_id] |= IN_LIST;
 
+	int begin = 0;
 	for(int i = 0; i < distance_from_border; i++)
 	{
 		//This is tricky! We'll recursivelly push things to
 		//the vector 'patch', but in a first step we want to push
 		//the neighbours of everyone inside 'patch', and in the
-		//second step do the same, over the old and the recently
-		//added elements, and the same for the i-th step (like a 
-		//fixed-point procedure). 
+		//second step do the same over the recently added elements,
+		//and the same for the i-th step (like a fixed-point procedure). 
 		//For this, we must fix the number of iterations
 		//we'll do, and that's why we store the size of the patch (sz)
 		//outside the FOR loop (if we used patch.size() inside the FOR
 		//loop, every iteration it would grow indefinitely until we
-		//covered the whole graph).
+		//covered the whole graph). Elements before BEGIN were expanded
+		//in the previous steps.
 		int sz = patch.size();
-		for(int p = 0; p < sz; p++)
+		for(int p = begin; p < sz; p++)
 		{			
 			//retrieve element. Keep in mind p is an indice,
 			//P is the actual element!
 			int P = patch[p];
 
 			//skip if this element was already visited
-			if( visited[P] & VISITED ) continue;
-			visited[P] |= VISITED;
-
-			const Node& N = nodes[P];
+			if( flags[P] & VISITED ) continue;
+			flags[P] |= VISITED;
 
-			for(int j = 0; j < N.n_incident_faces(); j++)
+			ConstSpan<int> adj = g.neighbours(P);
+			for(auto n = adj.begin(); n != adj.end(); ++n)
 			{
-				int n1 = N.get_face(j).first;
-				int n2 = N.get_face(j).second;
-
-				//if n1 or n2 were not pushed to the list yet, push it
-				//to the patch and remove from ranked_points.
-				//Notice we don't do ranked_points.erase(P)
-				//because we already remove them in these if
-				//statements (and point_id will be removed in
-				//the main loop, in feature_points() ).
-				if( !(visited[n1] & IN_LIST) ) 
+				//if the neighbour was not pushed to the list yet, push it
+				//to the patch and mark it as consumed (point_id is marked
+				//in the main loop, in feature_points() ).
+				if( !(flags[*n] & IN_LIST) ) 
 				{
-					ranked_points.remove( n1 );
-					patch.push_back( n1 );
-					visited[n1] |= IN_LIST;
-				}
-
-				if( !(visited[n2] & IN_LIST) ) 
-				{
-					ranked_points.remove( n2 );
-					patch.push_back( n2 );
-					visited[n2] |= IN_LIST;
+					consumed[*n] = region;
+					patch.push_back( *n );
+					flags[*n] |= IN_LIST;
 				}
 			}
 		}
+		begin = sz;
 	}
 
-	delete[] visited;
-
-	//compute normal (average of the normals)
+	//compute normal (average of the normals) and clear flags
 	glm::dvec3 avg_normal = glm::dvec3(0.0);
-	for(int i = 0; i < patch.size(); i++) avg_normal += nodes[ patch[i] ].get_normal();
+	for(unsigned int i = 0; i < patch.size(); i++)
+	{
+		avg_normal += g.get_normal( patch[i] );
+		flags[ patch[i] ] = 0;
+	}
 	avg_normal *= (1.0) / patch.size();
 
 	//push to patch and return
@@ -227,43 +152,100 @@ static void remove_spurious_patches(int threshold, std::vector<Patch>& features)
 	features.erase( std::remove_if(features.begin(), features.end(), thresh_func), features.end() );
 }
 
-static void paint_patches(std::vector<Node>& nodes, const std::vector<Patch>& features)
-{
-	//paint remaining patches
-	int c = 0;
-	for(auto p = features.begin(); p != features.end(); ++p)
-	{
-		//Choose color for this patch. This is just to make easier
-		//to see adjacent patches.
-		glm::vec3 color = glm::vec3(0.4f, 0.4f, 0.4f);
-		switch(c)
-		{
-			case 0: color = glm::vec3(0.0f, 1.0f, 0.0f); break;
-			case 1:	color = glm::vec3(1.0f, 0.0f, 0.0f); break;
-			case 2:	color = glm::vec3(0.0f, 0.0f, 1.0f); break;
-		}
-		c = c >= 2 ? 0 : c + 1;
-
-
-		p->paint_patch( nodes, color );
-	}
-}	
-
 //-----------------------------------------------------
 //------------------- FROM GRAPH.H --------------------
 //-----------------------------------------------------
+void Graph::reserve_nodes(unsigned int n)
+{
+	positions.own().reserve(n); normals.own().reserve(n); curvatures.own().reserve(n);
+	types.own().reserve(n);
+}
+
 void Graph::push_node(double x, double y, double z, double nx, double ny, double nz)
 {
-	this->nodes.push_back( Node( glm::dvec3(x,y,z), glm::dvec3(nx, ny, nz) ) );
+	this->positions.own().push_back( glm::dvec3(x, y, z) );
+	this->normals.own().push_back( glm::dvec3(nx, ny, nz) );
+	this->curvatures.own().push_back( glm::dvec3(0.0) );
+	this->types.own().push_back( FLAT );
 }
 
 void Graph::push_face(int a, int b, int c)
 {
-	this->nodes[a].push_triangular_face(b, c);
-	this->nodes[b].push_triangular_face(a, c);
-	this->nodes[c].push_triangular_face(a, b);
+	this->faces.own().push_back( (Face){a,b,c} );
+}
+
+//Builds the incident-face CSR with a counting sort over the face
+//list. Each node gets its faces in the same order they were pushed.
+void Graph::build_adjacency()
+{
+	int n = this->size();
+	std::vector<int>& offsets = adj_offsets.own();
+	std::vector< std::pair<int,int> >& pairs = adj_faces.own();
+	std::vector<int>& corners = adj_corners.own();
+
+	//count incident faces of each node, then turn counts into offsets
+	offsets.assign(n + 1, 0);
+	for(auto f = faces.begin(); f != faces.end(); ++f)
+	{
+		offsets[f->a + 1]++;
+		offsets[f->b + 1]++;
+		offsets[f->c + 1]++;
+	}
+
+	for(int i = 0; i < n; i++)
+		offsets[i+1] += offsets[i];
+
+	//scatter the two other vertices of every face into place,
+	//along with the corner of the face the node is
+	std::vector<int> cursor(offsets.begin(), offsets.end() - 1);
+	pairs.resize( offsets[n] );
+	corners.resize( offsets[n] );
+
+	for(unsigned int i = 0; i < faces.size(); i++)
+	{
+		const Face& f = faces[i];
+
+		corners[ cursor[f.a] ] = 3*i;
+		pairs[ cursor[f.a]++ ] = std::make_pair(f.b, f.c);
+
+		corners[ cursor[f.b] ] = 3*i + 1;
+		pairs[ cursor[f.b]++ ] = std::make_pair(f.a, f.c);
+
+		corners[ cursor[f.c] ] = 3*i + 2;
+		pairs[ cursor[f.c]++ ] = std::make_pair(f.a, f.b);
+	}
+
+	build_neighbours();
+}
+
+//Derives the distinct-neighbour CSR from the incident faces. Neighbours
+//keep the order in which they first show up in the faces, which is the
+//order the BFS routines used to visit them.
+void Graph::build_neighbours()
+{
+	int n = this->size();
+	std::vector<int>& offsets = ngbr_offsets.own();
+	std::vector<int>& list = ngbr.own();
 
-	this->faces.push_back( (Face){a,b,c} );
+	//last[v] == i means v was already listed as a neighbour of i
+	std::vector<int> last(n, -1);
+
+	offsets.assign(n + 1, 0);
+	list.clear();
+	list.reserve( adj_faces.size() );
+
+	for(int i = 0; i < n; i++)
+	{
+		for(int f = adj_offsets[i]; f < adj_offsets[i+1]; f++)
+		{
+			int n1 = adj_faces[f].first, n2 = adj_faces[f].second;
+
+			if(last[n1] != i) { last[n1] = i; list.push_back(n1); }
+			if(last[n2] != i) { last[n2] = i; list.push_back(n2); }
+		}
+
+		offsets[i+1] = list.size();
+	}
 }
 
 std::string Graph::graph2str()
@@ -271,144 +253,273 @@ std::string Graph::graph2str()
 	std::stringstream ss;
 
 	ss<<"Graph[ ";
-	for(auto it = nodes.begin(); it != nodes.end(); ++it)
-		ss<<it->node2str()<<", \n";
+	for(unsigned int i = 0; i < size(); i++)
+	{
+		const glm::dvec3 &pos = positions[i], &normal = normals[i], &curvature = curvatures[i];
+
+		ss<<"Node[ Pos = ("<<pos.x<<", "<<pos.y<<", "<<pos.z<<"), Normal = ("<<normal.x<<", "<<normal.y<<", "<<normal.z<<") ";
+		ss<<" Curvature = ("<<curvature.x<<", "<<curvature.y<<", "<<curvature.z<<") ["<<types[i]<<"] ] -> adj: ";
+		if(has_adjacency())
+		{
+			ConstSpan< std::pair<int,int> > adj = incident_faces(i);
+			for(auto f = adj.begin(); f != adj.end(); ++f)
+				ss<<"("<<f->first<<", "<<f->second<<"), ";
+		}
+		ss<<", \n";
+	}
 	ss<<"]";
 	
 	return ss.str();
 }
 
-//Compute curvature for each point in mesh
+//Compute curvature for each point in mesh. The curvature vector of a
+//point P is the sum, over the faces incident to P, of the unit vector
+//from P to the centroid of the face weighted by the angle of the face
+//at P. Every face contributes to its three corners, so we first compute
+//the contribution of each corner once per face, then each point just
+//adds up the contributions of its corners. Both passes run in parallel
+//and write to disjoint slots; the sums are always taken in the same
+//(CSR) order, so results don't depend on the number of threads.
 void Graph::compute_curvatures()
 {
-	for(auto n = nodes.begin(); n != nodes.end(); ++n)
-	{
-		glm::dvec3 acc;
+	//contribution of corner k of face f goes to corner[3*f + k]
+	std::vector<glm::dvec3> corner( 3*faces.size() );
+
+	parallel_for(0, faces.size(), [this, &corner](int begin, int end, int) {
+		corner_curvatures( &positions[0].x, &faces[0].a, begin, end, &corner[0].x );
+	});
 
-		for(int i = 0; i < n->n_incident_faces(); i++)
+	glm::dvec3* out = curvatures.own().data();
+	parallel_for(0, size(), [this, &corner, out](int begin, int end, int) {
+		for(int n = begin; n < end; n++)
 		{
-			std::pair<int,int> cur_face = n->get_face(i);
-			
-			glm::dvec3 P = n->get_pos();
-			glm::dvec3 Q1 = nodes[cur_face.first].get_pos(); 
-			glm::dvec3 Q2 = nodes[cur_face.second].get_pos();
-
-			glm::dvec3 U = triangle_centroid(P, Q1, Q2);
-
-			//Vectors point from current Node to the adjacent ones
-			//and to the centroid of the face
-			//HINT: some optimization could be made here storing
-			//all the vectors we already computed. Is this worth?
-			glm::dvec3 u = U - P, q1 = Q1 - P, q2 = Q2 - P;
-
-			//This is the angle formed by the vectors which go from
-			//the node to the adjacent ones
-			double alpha = glm::dot(q1, q2) / (glm::length(q1) * glm::length(q2)) ;
-			alpha = acos(alpha);
-
-			acc = acc + (alpha * (u / glm::length(u)) );
-		}
+			glm::dvec3 acc = glm::dvec3(0.0);
 
-		n->set_curvature(acc);
-	}
+			for(int i = adj_offsets[n]; i < adj_offsets[n+1]; i++)
+				acc += corner[ adj_corners[i] ];
+
+			out[n] = acc;
+		}
+	});
 }
 
 //Classify points into three groups: concave, convex or flat
 void Graph::classify_points()
 {
-	std::vector<glm::dvec3> point_cloud;
-	for(auto it = this->nodes.begin(); it != this->nodes.end(); ++it)
-		point_cloud.push_back( it->get_pos() );
+	glm::dvec3 centroid = cloud_centroid(positions);
+	const double c[3] = { centroid.x, centroid.y, centroid.z };
 
-	glm::dvec3 centroid = cloud_centroid(point_cloud);
-	for(auto it = this->nodes.begin(); it != this->nodes.end(); ++it)
-	{
-		double dot_centroid_curv = glm::dot(centroid - it->get_pos(), it->get_curvature());
-
-		if( d_equals(dot_centroid_curv, 0.0) )
-			it->set_convexity( FLAT );
-		else if( dot_centroid_curv > 0)
-			it->set_convexity( CONVEX );
-		else
-			it->set_convexity( CONCAVE );
-	}
+	Convexity* out = types.own().data();
+	parallel_for(0, size(), [this, &c, out](int begin, int end, int) {
+		classify_convexity( &positions[0].x, &curvatures[0].x, c, begin, end, out );
+	});
 }
 
-//Segment mesh into regions of convex-, concave- or flat-only points 
+//Segment mesh into regions of convex-, concave- or flat-only points.
+//Two adjacent points belong to the same region iff they have the same
+//convexity, so a single sweep over the edges of every face is enough:
+//no recursion, no visited table, and every connected component of the
+//mesh gets segmented (not only the one reachable from the first node).
+//The face list is split across threads which merge into a lock-free
+//union-find; its sets are then folded into UF. The sets don't depend
+//on the order of the merges, and clusters are numbered by their
+//smallest element afterwards, so the result is deterministic.
 void Graph::segment_by_curvature(UnionFind& uf)
 {
-	bool *visited = new bool[this->nodes.size()];
-	memset( visited, 0, sizeof(bool)*this->nodes.size() );
+	ConcurrentUnionFind cuf( this->size() );
+
+	parallel_for(0, faces.size(), [this, &cuf](int begin, int end, int) {
+		for(int i = begin; i < end; i++)
+		{
+			const Face& f = faces[i];
+			Convexity ta = types[f.a], tb = types[f.b], tc = types[f.c];
+
+			if( ta == tb ) cuf.merge(f.a, f.b);
+			if( tb == tc ) cuf.merge(f.b, f.c);
+			if( ta == tc ) cuf.merge(f.a, f.c);
+		}
+	});
+
+	for(unsigned int i = 0; i < this->size(); i++)
+		uf.merge(i, cuf.find(i));
+}
+
+//Geodesic distances between the seeds of PATCHES, up to CUTOFF: one
+//Dijkstra search along the mesh edges from each seed, stopped once it
+//gets farther than CUTOFF. Search i makes row i of the triangle (the
+//seeds of the patches after i it reaches), so the searches run in
+//parallel; each chunk of rows is built apart and they're concatenated
+//in order at the end.
+void Graph::compute_patch_geodesics(const std::vector<Patch>& patches, double cutoff)
+{
+	typedef struct {
+		std::vector<int> cols;
+		std::vector<float> dists;
+	} Rows;
+
+	const double INF = std::numeric_limits<double>::infinity();
+	int n = patches.size();
+
+	//patch seeded at each node, if any
+	std::vector<int> patch_of( this->size(), -1 );
+	for(int i = 0; i < n; i++) patch_of[ patches[i].get_seed() ] = i;
+
+	std::vector<int> row_size(n, 0);
+	std::vector<Rows> chunks( worker_count() );
+
+	parallel_for(0, n, [this, &patches, &patch_of, &row_size, &chunks, cutoff, INF](int begin, int end, int chunk) {
+		//scratch for the searches of this chunk: only the entries
+		//a search touched are reset after it
+		std::vector<double> dist( this->size(), INF );
+		std::vector<int> touched;
+		std::vector< std::pair<double,int> > heap;
+		std::vector< std::pair<int,float> > row;
+		std::greater< std::pair<double,int> > farther;
+
+		Rows& out = chunks[chunk];
+
+		for(int i = begin; i < end; i++)
+		{
+			int seed = patches[i].get_seed();
+			dist[seed] = 0.0; touched.push_back(seed);
+			heap.push_back( std::make_pair(0.0, seed) );
+
+			while(!heap.empty())
+			{
+				std::pop_heap(heap.begin(), heap.end(), farther);
+				double d = heap.back().first; int u = heap.back().second;
+				heap.pop_back();
+
+				//stale entry, u was reached by a shorter path
+				if(d > dist[u]) continue;
+
+				if(patch_of[u] > i) row.push_back( std::make_pair(patch_of[u], (float)d) );
+
+				ConstSpan<int> ngbrs = neighbours(u);
+				for(auto v = ngbrs.begin(); v != ngbrs.end(); ++v)
+				{
+					double dv = d + glm::length(positions[*v] - positions[u]);
+					if(dv > cutoff || dv >= dist[*v]) continue;
 
-	//recursively cluster nodes
-	cluster_nodes_by_type(0, visited, this->nodes, uf);
+					if(dist[*v] == INF) touched.push_back(*v);
+					dist[*v] = dv;
+					heap.push_back( std::make_pair(dv, *v) );
+					std::push_heap(heap.begin(), heap.end(), farther);
+				}
+			}
+
+			std::sort(row.begin(), row.end());
+			for(auto e = row.begin(); e != row.end(); ++e)
+			{
+				out.cols.push_back(e->first);
+				out.dists.push_back(e->second);
+			}
+			row_size[i] = row.size();
+			row.clear();
+
+			for(auto t = touched.begin(); t != touched.end(); ++t) dist[*t] = INF;
+			touched.clear();
+		}
+	});
+
+	PatchGeodesics& pg = this->patch_geodesics;
+	pg.cutoff = cutoff;
+
+	std::vector<int>& offsets = pg.row_offsets.own();
+	std::vector<int>& cols = pg.cols.own();
+	std::vector<float>& dists = pg.dists.own();
 
-	delete[] visited;
+	offsets.assign(n + 1, 0);
+	for(int i = 0; i < n; i++) offsets[i+1] = offsets[i] + row_size[i];
+
+	cols.clear(); dists.clear();
+	cols.reserve( offsets[n] ); dists.reserve( offsets[n] );
+	for(auto c = chunks.begin(); c != chunks.end(); ++c)
+	{
+		cols.insert(cols.end(), c->cols.begin(), c->cols.end());
+		dists.insert(dists.end(), c->dists.begin(), c->dists.end());
+	}
 }
 
 //Extracts feature points by expanding all points until the border is reached
 void Graph::feature_points(const UnionFind& uf, std::vector<Patch>& feature)
 {
-	//cluster points by convexity
-	std::vector< std::vector<int> > clusters;
-	uf.clusters(clusters);
+	//cluster points by convexity: the points of cluster r are
+	//members[ offsets[r] .. offsets[r+1] )
+	std::vector<int> offsets, members;
+	uf.clusters(offsets, members);
+	int n_clusters = offsets.size() - 1;
+
+	//region each point belongs to, and distance to the region's contour
+	std::vector<int> label( this->size() ), dist( this->size(), -1 ), queue;
+	for(int r = 0; r < n_clusters; r++)
+		for(int i = offsets[r]; i < offsets[r+1]; i++)
+			label[ members[i] ] = r;
+
+	//scratch space for generate_patch(), and the region in which
+	//each point was last consumed by a patch
+	std::vector<char> flags( this->size(), 0 );
+	std::vector<int> consumed( this->size(), -1 );
+
+	//points of the current region bucketed by distance from border
+	std::vector<int> bucket_offsets, bucket_points;
 
 	//get feature points from each cluster
-	for(auto region = clusters.begin(); region != clusters.end(); ++region)
+	for(int r = 0; r < n_clusters; r++)
 	{
-		//get contour for this cluster, i.e., the set of points on the border
-		std::set<int> contour;
-		get_contour_from_cluster(this->nodes, *region, contour);
-
-		//rank points according to distance from border: expand in breadth
-		//and stop when the first contour point is found. 
-		//We store the distances in the map G_DISTANCES, and our set of
-		//ranked points automatically sort the points acording to these stored distances.
-		std::list<int> ranked_points; 
-		
-		for(auto p = region->begin(); p != region->end(); ++p)
-		{
-			int dist_p = expand_node_in_breadth(this->nodes, contour, *p);
+		ConstSpan<int> region(members.data() + offsets[r], members.data() + offsets[r+1]);
 
-			//Avoid degenerated pairs (distance = -1).			
-			if(dist_p < 0) continue;
+		//rank points according to distance from border, i.e., from the
+		//contour of the cluster.
+		distance_to_contour(*this, region, label, dist, queue);
 
-			G_DISTANCES.insert( std::pair<int,int>(*p, dist_p) );
-			ranked_points.push_back( *p );
-		}
+		//bucket-sort points by distance (counting sort). Degenerated
+		//points (distance = -1) are left out. Inside a bucket points
+		//keep the order of the region.
+		int max_dist = -1;
+		for(auto p = region.begin(); p != region.end(); ++p)
+			max_dist = std::max(max_dist, dist[*p]);
+
+		bucket_offsets.assign(max_dist + 2, 0);
+		for(auto p = region.begin(); p != region.end(); ++p)
+			if(dist[*p] >= 0) bucket_offsets[ dist[*p] + 1 ]++;
+
+		for(int d = 0; d <= max_dist; d++)
+			bucket_offsets[d+1] += bucket_offsets[d];
+
+		bucket_points.resize( bucket_offsets[max_dist + 1] );
+		for(auto p = region.begin(); p != region.end(); ++p)
+			if(dist[*p] >= 0) bucket_points[ bucket_offsets[dist[*p]]++ ] = *p;
 
-		//sort points by distance
-		ranked_points.sort( comp_by_distance );
+		//the scatter above moved each offset to the start of the next bucket
+		for(int d = max_dist; d > 0; d--)
+			bucket_offsets[d] = bucket_offsets[d-1];
+		if(max_dist >= 0) bucket_offsets[0] = 0;
 
 		//expand each point until the border is reached; the collected points
 		//in this process makes up the final patches we'll use to compute
 		//feature points.
-		//As ranked_points is a binary search tree ordered by distance (as we
-		//defined in ranked_point declaration), at each step we take the first
-		//element (i.e. the greatest), generate the patch, then we remove it.
-		//In the next iteration we'll have the second largest element in the
-		//first position.
-		int point_index = 0;
-		while(!ranked_points.empty())
+		//We take points from the furthest bucket to the closest one: each
+		//unconsumed point generates a patch, and every point collected in
+		//that patch is consumed, so it is lazily skipped when its turn comes.
+		for(int d = max_dist; d >= 0; d--)
 		{
-			//expand points which are furthest from the contour
-			//until we cover the entire region. generate_patch will
-			//remove all nodes from ranked_points which were clustered into a patch.
-
-			int point_id = *ranked_points.begin();
-
-			//TODO: PATCH should be able to capture r-values by use of move semantics in the =operator
-			Patch final_patch = generate_patch(this->nodes, ranked_points, point_id);
+			for(int i = bucket_offsets[d]; i < bucket_offsets[d+1]; i++)
+			{
+				int point_id = bucket_points[i];
+				if(consumed[point_id] == r) continue;
+				consumed[point_id] = r;
 
-			//curvature of patch will be that of the seed point. Is there a better
-			//way to compute it? As it will be used only to check whether patch
-			//is convex or concave, maybe we won't need much more than that.
-			final_patch.set_curvature( this->nodes[point_id].get_curvature() );
+				//TODO: PATCH should be able to capture r-values by use of move semantics in the =operator
+				Patch final_patch = generate_patch(*this, point_id, d, r, consumed, flags);
 
-			//remove point from tree
-			ranked_points.erase( ranked_points.begin() );
+				//curvature of patch will be that of the seed point. Is there a better
+				//way to compute it? As it will be used only to check whether patch
+				//is convex or concave, maybe we won't need much more than that.
+				final_patch.set_curvature( this->curvatures[point_id] );
 
-			feature.push_back( final_patch );
+				feature.push_back( final_patch );
+			}
 		}
 	}
 
@@ -416,32 +527,30 @@ void Graph::feature_points(const UnionFind& uf, std::vector<Patch>& feature)
 	remove_spurious_patches(Parameters::PATCH_SIZE_THRESH, feature);
 }
 
-//Applies transformation T to all nodes
+void Graph::contour_distances(const UnionFind& uf, std::vector<int>& dist) const
+{
+	std::vector<int> offsets, members, queue;
+	uf.clusters(offsets, members);
+	int n_clusters = offsets.size() - 1;
+
+	std::vector<int> label( this->size() );
+	for(int r = 0; r < n_clusters; r++)
+		for(int i = offsets[r]; i < offsets[r+1]; i++)
+			label[ members[i] ] = r;
+
+	dist.assign( this->size(), -1 );
+	for(int r = 0; r < n_clusters; r++)
+	{
+		ConstSpan<int> region(members.data() + offsets[r], members.data() + offsets[r+1]);
+		distance_to_contour(*this, region, label, dist, queue);
+	}
+}
+
+//Poses the cloud with transformation T (replacing the last one). The
+//nodes aren't touched: TransformedView applies it as they're read.
 void Graph::transform_cloud(const glm::dmat4& T)
 {
-	//if this is the first call to the function, copy
-	//contents of nodes to original_cloud
-	if(original_nodes.empty())
-		original_nodes.assign( nodes.begin(), nodes.end() );
-
-	//TODO: This is EXTREMELY inefficient, as every call to transform we'll
-	//need to copy an entire vector. Is there a better way? Maybe storing
-	//the last transformation, inverting it, composing the inverse with
-	//current T?
-	//
-	// T0 [last transformation], T [current transformation]
-	//
-	// Pi : cloud points
-	//
-	// After T0, cloud points become  T0.Pi
-	// To apply T as we want, apply T' = T.T0⁻¹
-	// to get   (T.T0⁻¹)T0.Pi = T.Pi
-
-	//Copy original nodes before applying transformation
-	nodes.assign( original_nodes.begin(), original_nodes.end() );
-	
-	for(auto n = this->nodes.begin(); n != this->nodes.end(); ++n)
-		n->transform_node(T);
+	pose = T;
 }
 
 //Sets the base color for this molecule. If this function
@@ -449,25 +558,34 @@ void Graph::transform_cloud(const glm::dmat4& T)
 //white.
 void Graph::set_base_color(const glm::vec3& color)
 {
-	for(auto n = this->nodes.begin(); n != this->nodes.end(); ++n)
-		n->set_color(color);
+	this->color = color;
 }
 
 void Graph::preprocess_mesh(std::vector< std::pair<Patch, Descriptor> >& out)
 {
+	if(!has_adjacency()) build_adjacency();
+
 	compute_curvatures();
 	
 	classify_points();
 
-	UnionFind uf( this->nodes.size() );
+	UnionFind uf( this->size() );
 	segment_by_curvature(uf);
 
 	std::vector<Patch> patches;
 	feature_points(uf, patches);
 
-	for(auto p = patches.begin(); p != patches.end(); ++p)
-	{
-		Descriptor d = p->compute_descriptor( this->nodes );
-		out.push_back( std::make_pair(*p, d) );
-	}
+	//grouping only compares distances with G_THRESH
+	compute_patch_geodesics(patches, Parameters::G_THRESH);
+
+	//patches are independent, so they're described in parallel
+	std::vector<Descriptor> descriptors( patches.size() );
+	parallel_for(0, patches.size(), [this, &patches, &descriptors](int begin, int end, int) {
+		for(int i = begin; i < end; i++)
+			descriptors[i] = patches[i].compute_descriptor( this->positions );
+	});
+
+	out.reserve( out.size() + patches.size() );
+	for(unsigned int i = 0; i < patches.size(); i++)
+		out.push_back( std::make_pair(patches[i], descriptors[i]) );
 }
\ No newline at end of file
@@ -3,24 +3,48 @@
 
 #include <iostream>
 #include <glm/glm.hpp>
-#include <glm/gtc/type_ptr.hpp>
-#include <glm/gtc/matrix_access.hpp>
-#include <glm/gtx/string_cast.hpp>
-#include <gsl/gsl_math.h>
-#include <gsl/gsl_eigen.h>
-#include <gsl/gsl_blas.h>
 
 //-------------------------------------------------------------------
 //-------------------------- INTERNAL -------------------------------
 //-------------------------------------------------------------------
-static void build_vector_of_points(const std::vector<Node>& nodes, const std::vector<int>& patch, std::vector<glm::dvec3>& out)
+//Computes, in a single pass over the points of the patch, their
+//centroid and their scatter matrix (covariance times number of points).
+//The scatter is accumulated relative to the first point, which is
+//close to all the others, so subtracting the mean at the end doesn't
+//cancel out most significant digits as the textbook formula would.
+static void scatter_matrix(ConstSpan<glm::dvec3> positions,
+						   const std::vector<int>& nodes,
+						   glm::dvec3& centroid,
+						   double scatter[3][3])
 {
-	for(auto it = patch.begin(); it != patch.end(); ++it)
-		out.push_back( nodes[*it].get_pos() );
+	const glm::dvec3 shift = positions[ nodes[0] ];
+	glm::dvec3 sum = glm::dvec3(0.0), sum_d = glm::dvec3(0.0);
+	double sxx = 0.0, sxy = 0.0, sxz = 0.0, syy = 0.0, syz = 0.0, szz = 0.0;
+
+	for(auto n = nodes.begin(); n != nodes.end(); ++n)
+	{
+		const glm::dvec3& p = positions[*n];
+		glm::dvec3 d = p - shift;
+
+		sum += p; sum_d += d;
+		sxx += d.x*d.x; sxy += d.x*d.y; sxz += d.x*d.z;
+		syy += d.y*d.y; syz += d.y*d.z; szz += d.z*d.z;
+	}
+
+	double n = nodes.size();
+	centroid = sum / n;
+
+	glm::dvec3 m = sum_d / n;
+	scatter[0][0] = sxx - n*m.x*m.x;
+	scatter[1][1] = syy - n*m.y*m.y;
+	scatter[2][2] = szz - n*m.z*m.z;
+	scatter[0][1] = scatter[1][0] = sxy - n*m.x*m.y;
+	scatter[0][2] = scatter[2][0] = sxz - n*m.x*m.z;
+	scatter[1][2] = scatter[2][1] = syz - n*m.y*m.z;
 }
 
-static void least_evec_eval(const glm::dmat3 evec, 
-							const glm::dvec3 eval, 
+static void least_evec_eval(const double evec[3][3], 
+							const double eval[3], 
 							glm::dvec3& least_evec,
 							double& least_eval)
 {
@@ -28,50 +52,8 @@ static void least_evec_eval(const glm::dmat3 evec,
 	for(int i = 0; i < 3; i++)
 		if( eval[i] < eval[least_i] ) least_i = i;
 
-	least_eval = least_i;
-	least_evec = glm::column(evec, least_i);
-}
-
-static void principal_component_analysis(const std::vector<glm::dvec3>& points, 
-									glm::dmat3& out_eigen_vec, 
-									glm::dvec3& out_eigen_val)
-{
-	//3 rows, n columns
-	int nrows = 3, ncolumns = points.size();
-	gsl_matrix* data = gsl_matrix_alloc(nrows, ncolumns);
-
-	//Build matrix where each column is one of the points in region
-	for(int i = 0; i < ncolumns; i++)
-	{	
-		//Set column i with px, py and pz
-		gsl_matrix_set(data, 0, i, points[i][0]);
-		gsl_matrix_set(data, 1, i, points[i][1]);
-		gsl_matrix_set(data, 2, i, points[i][2]);
-	}
-
-	//transpose matrix
-	gsl_matrix* data_t = gsl_matrix_alloc(ncolumns, nrows);
-	gsl_matrix_transpose_memcpy(data_t, data);
-
-	//multiply matrices
-	gsl_matrix* covar = gsl_matrix_calloc(3, 3);
-	gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, data, data_t, 0.0, covar);
-
-	//eigendecompose covariance matrix
-	gsl_eigen_symmv_workspace* eigen_aux = gsl_eigen_symmv_alloc(3);
-	gsl_vector* eigen_val = gsl_vector_alloc(3);
-	gsl_matrix* eigen_vec = gsl_matrix_alloc(3, 3);
-
-	gsl_eigen_symmv(covar, eigen_val, eigen_vec, eigen_aux);
-
-	//build final matrix -> TODO: do we need to transpose/invert?
-	memcpy( glm::value_ptr(out_eigen_val), eigen_val->data, 3*sizeof(double) );	
-	memcpy( glm::value_ptr(out_eigen_vec), eigen_vec->data, 9*sizeof(double) );
-
-	//delete pointers
-	gsl_matrix_free(data); gsl_matrix_free(data_t); gsl_matrix_free(covar);
-	gsl_matrix_free(eigen_vec); gsl_vector_free(eigen_val);
-	gsl_eigen_symmv_free(eigen_aux);
+	least_eval = eval[least_i];
+	least_evec = glm::dvec3(evec[0][least_i], evec[1][least_i], evec[2][least_i]);
 }
 
 //-----------------------------------------------------------------------
@@ -85,33 +67,27 @@ Patch::Patch(const glm::dvec3& normal, const std::vector<int>& nodes)
 	this->nodes = std::move(nodes);
 }
 
-void Patch::paint_patch(std::vector<Node>& graph, const glm::vec3& color) const
+void Patch::paint_patch(std::vector<glm::vec3>& colors, const glm::vec3& color) const
 {
 	for(auto n = this->nodes.begin(); n != this->nodes.end(); ++n)
-		graph[*n].set_color(color);
+		colors[*n] = color;
 }
 
 //TODO: So far, PCA is still useless, but we'll use it when aligning daisies
 //so to compute DRINK descriptor.
-Descriptor Patch::compute_descriptor(const std::vector<Node>& points)
+//It streams over the patch points once and solves the 3x3 eigenproblem
+//in place, so it doesn't allocate: patches can be described in parallel.
+Descriptor Patch::compute_descriptor(ConstSpan<glm::dvec3> positions)
 {
-	//build vector with point positions
-	std::vector<glm::dvec3> p;
-	build_vector_of_points(points, this->nodes, p);
-
-	//compute patches centroid; remember PCA must be done when
-	//mean of all points is zero
-	this->centroid = cloud_centroid(p);
+	//PCA must be done when mean of all points is zero, so
+	//we work with the scatter matrix around the centroid
+	double scatter[3][3];
+	scatter_matrix(positions, this->nodes, this->centroid, scatter);
 
-	//translate centroid to origin
-	for(auto it = p.begin(); it != p.end(); ++it)
-		*it = *it - centroid;
-
-	//PCA of translated cloud point
-	glm::dmat3 eigen_vec; glm::dvec3 eigen_val;
+	double eigen_vec[3][3], eigen_val[3];
 	glm::dvec3 least_evec; double least_eval;
-	
-	principal_component_analysis(p, eigen_vec, eigen_val);
+
+	symmetric_eigen<3>(scatter, eigen_val, eigen_vec);
 	least_evec_eval(eigen_vec, eigen_val, least_evec, least_eval);
 
 	//first, totally naïve descriptor: just store "curvature"
@@ -0,0 +1,355 @@
+#include "../../inc/io/fileio.h"
+#include "../../inc/io/mapped_file.h"
+#include "../../inc/util/checksum.h"
+#include "../../inc/parameters.h"
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <atomic>
+#include <fstream>
+
+#include <iostream>
+
+//------------------------------------------
+//--------------- INTERNAL -----------------
+//------------------------------------------
+// Layout of a cache file (all values in host byte order):
+//
+//	CacheHeader
+//	positions		n_nodes		x 3 doubles
+//	normals			n_nodes		x 3 doubles
+//	curvatures		n_nodes		x 3 doubles
+//	types			n_nodes		x int32
+//	faces			n_faces		x 3 int32
+//	adj_offsets		n_nodes + 1	x int32		(incident faces of node i are
+//	adj_pairs		n_incident	x 2 int32	 adj_pairs[adj_offsets[i] .. adj_offsets[i+1]) )
+//	adj_corners		n_incident	x int32
+//	ngbr_offsets	n_nodes + 1	x int32		(distinct neighbours of node i are
+//	ngbr			n_neighbours x int32	 ngbr[ngbr_offsets[i] .. ngbr_offsets[i+1]) )
+//	patches			n_patches	x CachedPatch
+//	patch_nodes		n_patch_nodes x int32
+//	geo_offsets		n_patches + 1	x int32		(patches within the geodesic cutoff of
+//	geo_cols		n_geodesics	x int32		 patch i, after it: geo_cols[geo_offsets[i] ..
+//	geo_dists		n_geodesics	x float		 geo_offsets[i+1]), at geo_dists)
+//
+// Every section starts at an 8-byte boundary, so the arrays are used
+// straight from the mapped file: a loaded Graph views them in place and
+// keeps the mapping (only the patches are copied out, into their
+// Patch objects). The checksum covers everything after the header.
+static const char CACHE_MAGIC[8] = { 'S', 'P', 'D', 'O', 'C', 'K', 'C', '\0' };
+static const uint32_t CACHE_VERSION = 8;
+
+typedef struct {
+	char magic[8];
+	uint32_t version;
+	uint32_t header_size;
+	uint64_t payload_size;
+	uint64_t checksum;
+
+	//what the cache was built from
+	uint64_t vert_size, face_size;
+	int64_t vert_mtime, face_mtime;
+	double geodesic_cutoff;
+	int32_t patch_size_thresh;
+
+	//element counts
+	uint32_t n_nodes, n_faces, n_incident;
+	uint32_t n_patches, n_patch_nodes;
+	uint32_t n_geodesics, n_neighbours;
+} CacheHeader;
+
+typedef struct {
+	double normal[3], centroid[3], curvature[3];
+	double curv;
+	int32_t type;
+	uint32_t first, count;
+	uint32_t pad;
+} CachedPatch;
+
+static_assert(sizeof(CacheHeader) % 8 == 0, "cache sections must stay 8-byte aligned");
+static_assert(sizeof(CachedPatch) % 8 == 0, "cache sections must stay 8-byte aligned");
+static_assert(sizeof(std::pair<int,int>) == 2*sizeof(int32_t), "adjacency pairs are stored as two int32");
+static_assert(sizeof(glm::dvec3) == 3*sizeof(double), "node vectors are stored as three doubles");
+static_assert(sizeof(Face) == 3*sizeof(int32_t), "faces are stored as three int32");
+static_assert(sizeof(Convexity) == sizeof(int32_t), "types are stored as int32");
+
+static bool file_stamp(const std::string& path, uint64_t& size, int64_t& mtime)
+{
+	struct stat st;
+	if(stat(path.c_str(), &st) != 0) return false;
+
+	size = st.st_size;
+	mtime = st.st_mtime;
+	return true;
+}
+
+//Appends raw sections to the payload buffer, keeping 8-byte alignment
+static void put(std::vector<char>& buf, const void* data, size_t n)
+{
+	const char* p = static_cast<const char*>(data);
+	buf.insert(buf.end(), p, p + n);
+	while(buf.size() % 8 != 0) buf.push_back(0);
+}
+
+//Hands out consecutive sections of the mapped payload. Returns NULL if
+//the requested section would go past the end of the file.
+static const char* take(const char*& p, const char* end, size_t n)
+{
+	size_t padded = (n + 7) & ~size_t(7);
+	if( (size_t)(end - p) < padded ) return NULL;
+
+	const char* section = p;
+	p += padded;
+	return section;
+}
+
+//Whether the N indices at V are all in [0, LIMIT)
+static bool in_range(const int32_t* v, uint64_t n, uint64_t limit)
+{
+	for(uint64_t i = 0; i < n; i++)
+		if( v[i] < 0 || (uint64_t)v[i] >= limit ) return false;
+	return true;
+}
+
+//-----------------------------------------------
+//--------------- FROM FILEIO.H -----------------
+//-----------------------------------------------
+bool FileIO::save_cache(const std::string& path, const std::string& vert, const std::string& face,
+						const Graph& g, const std::vector< std::pair<Patch, Descriptor> >& desc)
+{
+	CacheHeader h;
+	memset(&h, 0, sizeof(CacheHeader));
+	memcpy(h.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	h.version = CACHE_VERSION;
+	h.header_size = sizeof(CacheHeader);
+	h.patch_size_thresh = Parameters::PATCH_SIZE_THRESH;
+	h.geodesic_cutoff = g.patch_geodesics.get_cutoff();
+
+	if( !file_stamp(vert, h.vert_size, h.vert_mtime) ) return false;
+	if( !file_stamp(face, h.face_size, h.face_mtime) ) return false;
+
+	h.n_nodes = g.size();
+	h.n_faces = g.faces.size();
+	h.n_patches = desc.size();
+
+	//node attributes, faces and adjacency are already flat,
+	//we store them as they are
+	if(!g.has_adjacency()) return false;
+	h.n_incident = g.adj_faces.size();
+
+	h.n_neighbours = g.ngbr.size();
+
+	const PatchGeodesics& geo = g.patch_geodesics;
+	if(geo.size() != (int)desc.size()) return false;
+	h.n_geodesics = geo.cols.size();
+
+	std::vector<CachedPatch> patches(h.n_patches);
+	std::vector<int32_t> patch_nodes;
+	for(unsigned int i = 0; i < h.n_patches; i++)
+	{
+		const Patch& P = desc[i].first;
+		CachedPatch& cp = patches[i];
+		memset(&cp, 0, sizeof(CachedPatch));
+
+		for(int k = 0; k < 3; k++)
+		{
+			cp.normal[k] = P.normal[k];
+			cp.centroid[k] = P.centroid[k];
+			cp.curvature[k] = P.curvature[k];
+		}
+		cp.curv = desc[i].second.curv;
+		cp.type = desc[i].second.type;
+		cp.first = patch_nodes.size();
+		cp.count = P.nodes.size();
+
+		patch_nodes.insert(patch_nodes.end(), P.nodes.begin(), P.nodes.end());
+	}
+	h.n_patch_nodes = patch_nodes.size();
+
+	//build payload
+	std::vector<char> payload;
+	put(payload, g.positions.data(), h.n_nodes*sizeof(glm::dvec3));
+	put(payload, g.normals.data(), h.n_nodes*sizeof(glm::dvec3));
+	put(payload, g.curvatures.data(), h.n_nodes*sizeof(glm::dvec3));
+	put(payload, g.types.data(), h.n_nodes*sizeof(int32_t));
+	put(payload, g.faces.data(), h.n_faces*sizeof(Face));
+	put(payload, g.adj_offsets.data(), g.adj_offsets.size()*sizeof(int32_t));
+	put(payload, g.adj_faces.data(), g.adj_faces.size()*2*sizeof(int32_t));
+	put(payload, g.adj_corners.data(), g.adj_corners.size()*sizeof(int32_t));
+	put(payload, g.ngbr_offsets.data(), g.ngbr_offsets.size()*sizeof(int32_t));
+	put(payload, g.ngbr.data(), g.ngbr.size()*sizeof(int32_t));
+	put(payload, patches.data(), patches.size()*sizeof(CachedPatch));
+	put(payload, patch_nodes.data(), patch_nodes.size()*sizeof(int32_t));
+	put(payload, geo.row_offsets.data(), geo.row_offsets.size()*sizeof(int32_t));
+	put(payload, geo.cols.data(), geo.cols.size()*sizeof(int32_t));
+	put(payload, geo.dists.data(), geo.dists.size()*sizeof(float));
+
+	h.payload_size = payload.size();
+	h.checksum = checksum(payload.data(), payload.size());
+
+	//write to a temporary file and rename it, so readers never
+	//see a half-written cache. The name is unique to this writer, as
+	//several jobs (or processes) may be saving the same surface.
+	static std::atomic<unsigned int> n_writes(0);
+	std::string tmp = path + ".tmp." + std::to_string(getpid()) + "." + std::to_string(n_writes++);
+	std::fstream out;
+	out.open(tmp, std::fstream::out | std::fstream::binary | std::fstream::trunc);
+	if(!out.is_open()) return false;
+
+	out.write(reinterpret_cast<const char*>(&h), sizeof(CacheHeader));
+	out.write(payload.data(), payload.size());
+	out.close();
+
+	if(out.fail() || rename(tmp.c_str(), path.c_str()) != 0)
+	{
+		remove(tmp.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+bool FileIO::load_cache(const std::string& path, const std::string& vert, const std::string& face,
+						Graph& g, std::vector< std::pair<Patch, Descriptor> >& desc, LoadStats* stats)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	MappedFile file;
+	if(!file.open(path)) return false;
+	if(file.size() < sizeof(CacheHeader)) return false;
+
+	CacheHeader h;
+	memcpy(&h, file.begin(), sizeof(CacheHeader));
+
+	//check format and freshness
+	if( memcmp(h.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ) return false;
+	if( h.version != CACHE_VERSION || h.header_size != sizeof(CacheHeader) ) return false;
+	if( h.payload_size != file.size() - sizeof(CacheHeader) ) return false;
+	if( h.patch_size_thresh != Parameters::PATCH_SIZE_THRESH ) return false;
+	if( h.geodesic_cutoff != Parameters::G_THRESH ) return false;
+
+	uint64_t size; int64_t mtime;
+	if( !file_stamp(vert, size, mtime) || size != h.vert_size || mtime != h.vert_mtime ) return false;
+	if( !file_stamp(face, size, mtime) || size != h.face_size || mtime != h.face_mtime ) return false;
+
+	const char *p = file.begin() + sizeof(CacheHeader), *end = file.end();
+	if( checksum(p, h.payload_size) != h.checksum ) return false;
+
+	//locate sections
+	const double *positions	= (const double*) take(p, end, 3*sizeof(double)*h.n_nodes);
+	const double *normals	= (const double*) take(p, end, 3*sizeof(double)*h.n_nodes);
+	const double *curvatures	= (const double*) take(p, end, 3*sizeof(double)*h.n_nodes);
+	const int32_t *types		= (const int32_t*) take(p, end, sizeof(int32_t)*h.n_nodes);
+	const int32_t *faces		= (const int32_t*) take(p, end, 3*sizeof(int32_t)*h.n_faces);
+	const int32_t *adj_offsets	= (const int32_t*) take(p, end, sizeof(int32_t)*(h.n_nodes + 1));
+	const int32_t *adj_pairs	= (const int32_t*) take(p, end, 2*sizeof(int32_t)*h.n_incident);
+	const int32_t *adj_corners	= (const int32_t*) take(p, end, sizeof(int32_t)*h.n_incident);
+	const int32_t *ngbr_offsets	= (const int32_t*) take(p, end, sizeof(int32_t)*(h.n_nodes + 1));
+	const int32_t *ngbr			= (const int32_t*) take(p, end, sizeof(int32_t)*h.n_neighbours);
+	const CachedPatch *patches	= (const CachedPatch*) take(p, end, sizeof(CachedPatch)*h.n_patches);
+	const int32_t *patch_nodes	= (const int32_t*) take(p, end, sizeof(int32_t)*h.n_patch_nodes);
+	const int32_t *geo_offsets	= (const int32_t*) take(p, end, sizeof(int32_t)*(h.n_patches + 1));
+	const int32_t *geo_cols		= (const int32_t*) take(p, end, sizeof(int32_t)*h.n_geodesics);
+	const float *geo_dists		= (const float*) take(p, end, sizeof(float)*h.n_geodesics);
+
+	if(!positions || !normals || !curvatures || !types || !faces ||
+		!adj_offsets || !adj_pairs || !adj_corners || !ngbr_offsets || !ngbr || !patches || !patch_nodes ||
+		!geo_offsets || !geo_cols || !geo_dists) return false;
+
+	if( adj_offsets[0] != 0 || adj_offsets[h.n_nodes] != (int32_t)h.n_incident ) return false;
+	for(unsigned int i = 0; i < h.n_nodes; i++)
+		if( adj_offsets[i] > adj_offsets[i+1] ) return false;
+	if( ngbr_offsets[0] != 0 || ngbr_offsets[h.n_nodes] != (int32_t)h.n_neighbours ) return false;
+	for(unsigned int i = 0; i < h.n_nodes; i++)
+		if( ngbr_offsets[i] > ngbr_offsets[i+1] ) return false;
+	for(unsigned int i = 0; i < h.n_patches; i++)
+		if( patches[i].count == 0 || (uint64_t)patches[i].first + patches[i].count > h.n_patch_nodes ||
+			patches[i].type < CONVEX || patches[i].type > FLAT ) return false;
+	if( geo_offsets[0] != 0 || geo_offsets[h.n_patches] != (int32_t)h.n_geodesics ) return false;
+	for(unsigned int i = 0; i < h.n_patches; i++)
+		if( geo_offsets[i] > geo_offsets[i+1] ) return false;
+
+	//every index must point into its section: a corrupt (or forged)
+	//cache mustn't make us read out of bounds later on
+	if( !in_range(faces, 3*(uint64_t)h.n_faces, h.n_nodes) ) return false;
+	if( !in_range(adj_pairs, 2*(uint64_t)h.n_incident, h.n_nodes) ) return false;
+	if( !in_range(adj_corners, h.n_incident, 3*(uint64_t)h.n_faces) ) return false;
+	if( !in_range(ngbr, h.n_neighbours, h.n_nodes) ) return false;
+	if( !in_range(patch_nodes, h.n_patch_nodes, h.n_nodes) ) return false;
+	if( !in_range(geo_cols, h.n_geodesics, h.n_patches) ) return false;
+	for(unsigned int i = 0; i < h.n_nodes; i++)
+		if( types[i] < CONVEX || types[i] > FLAT ) return false;
+
+	//the graph views the sections in place, and keeps the mapping
+	g.positions.view(reinterpret_cast<const glm::dvec3*>(positions), h.n_nodes);
+	g.normals.view(reinterpret_cast<const glm::dvec3*>(normals), h.n_nodes);
+	g.curvatures.view(reinterpret_cast<const glm::dvec3*>(curvatures), h.n_nodes);
+	g.types.view(reinterpret_cast<const Convexity*>(types), h.n_nodes);
+	g.faces.view(reinterpret_cast<const Face*>(faces), h.n_faces);
+	g.pose = glm::dmat4(1.0);
+
+	g.adj_offsets.view(adj_offsets, h.n_nodes + 1);
+	g.adj_faces.view(reinterpret_cast<const std::pair<int,int>*>(adj_pairs), h.n_incident);
+	g.adj_corners.view(adj_corners, h.n_incident);
+	g.ngbr_offsets.view(ngbr_offsets, h.n_nodes + 1);
+	g.ngbr.view(ngbr, h.n_neighbours);
+
+	PatchGeodesics& geo = g.patch_geodesics;
+	geo.cutoff = h.geodesic_cutoff;
+	geo.row_offsets.view(geo_offsets, h.n_patches + 1);
+	geo.cols.view(geo_cols, h.n_geodesics);
+	geo.dists.view(geo_dists, h.n_geodesics);
+
+	//the old mapping of G (if any) goes away with FILE, now that
+	//nothing views it
+	g.file.swap(file);
+
+	//rebuild patches and descriptors
+	desc.clear();
+	desc.reserve(h.n_patches);
+	for(unsigned int i = 0; i < h.n_patches; i++)
+	{
+		const CachedPatch& cp = patches[i];
+		const int32_t* first = patch_nodes + cp.first;
+
+		Patch P( glm::dvec3(cp.normal[0], cp.normal[1], cp.normal[2]),
+				std::vector<int>(first, first + cp.count) );
+		P.centroid = glm::dvec3(cp.centroid[0], cp.centroid[1], cp.centroid[2]);
+		P.curvature = glm::dvec3(cp.curvature[0], cp.curvature[1], cp.curvature[2]);
+
+		desc.push_back( std::make_pair(P, (Descriptor){cp.curv, (Convexity) cp.type}) );
+	}
+
+	if(stats)
+	{
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		stats->bytes = g.file.size();
+		stats->seconds = elapsed.count();
+		stats->from_cache = true;
+	}
+
+	return true;
+}
+
+bool FileIO::surface_from_file(const std::string& basename, Graph& g,
+								std::vector< std::pair<Patch, Descriptor> >& desc, LoadStats* stats)
+{
+	std::string vert(basename + ".vert");
+	std::string face(basename + ".face");
+	std::string cache(basename + ".spdc");
+
+	if( load_cache(cache, vert, face, g, desc, stats) ) return true;
+
+	if( !mesh_from_file(vert, face, g, stats) ) return false;
+	g.preprocess_mesh(desc);
+
+	//not being able to write the cache is not an error, we'll just
+	//preprocess the surface again next time
+	if( !save_cache(cache, vert, face, g, desc) )
+		std::cerr<<"Could not write surface cache "<<cache<<std::endl;
+
+	return true;
+}
@@ -1,93 +1,226 @@
 #include "../../inc/io/fileio.h"
-#include <fstream>
-#include <sstream>
+#include "../../inc/io/mapped_file.h"
 #include <string>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
 
 #include <iostream>
 
 //------------------------------------------
 //--------------- INTERNAL -----------------
 //------------------------------------------
-const unsigned int IGNORE_N = 256;
+// MSMS files are scanned in place over the mapped contents: no getline,
+// no stringstream, no temporary strings. Every scanner takes the cursor
+// by reference and never reads past END.
 
-static void load_vertex(std::string line, Graph& g)
+//Number of fields we need from each line of a .vert file (x y z nx ny nz)
+//and from each line of a .face file (v1 v2 v3). The remaining fields
+//(sphere numbers, face types, etc.) are skipped.
+const int VERT_FIELDS = 6;
+const int FACE_FIELDS = 3;
+
+static const double POW10[] = {
+	1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static inline bool is_blank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+static inline bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+static inline void skip_blanks(const char*& p, const char* end)
+{
+	while(p != end && is_blank(*p)) ++p;
+}
+
+//Moves P to the first character of the next line
+static inline void skip_line(const char*& p, const char* end)
 {
-	std::stringstream ss(line);
+	while(p != end && *p != '\n') ++p;
+	if(p != end) ++p;
+}
+
+//Parses a signed integer. Returns false (leaving P untouched)
+//if there's no number at P.
+static bool scan_int(const char*& p, const char* end, long& out)
+{
+	const char* c = p;
+	bool neg = false;
 
-	double x, y, z;
-	ss>>x>>y>>z;
+	if(c != end && (*c == '-' || *c == '+')) neg = (*c++ == '-');
+	if(c == end || !is_digit(*c)) return false;
 
-	double nx, ny, nz;
-	ss>>nx>>ny>>nz;
+	long v = 0;
+	while(c != end && is_digit(*c)) v = v*10 + (*c++ - '0');
 
-	g.push_node(x, y, z, nx, ny, nz);
+	out = neg ? -v : v;
+	p = c;
+	return true;
 }
 
-static void load_vertice(std::string vert, Graph& g)
+//Parses a decimal number of the form [+-]ddd[.ddd][(e|E)[+-]ddd].
+//The digits are accumulated into an integer mantissa and scaled once
+//by an exact power of ten, which is correctly rounded for the short
+//fixed-point numbers MSMS writes.
+static bool scan_double(const char*& p, const char* end, double& out)
 {
-	std::fstream in;
-	in.open(vert, std::fstream::in);
+	const char* c = p;
+	bool neg = false;
 
-	//Consume first three lines, which are just header info
-	in.ignore(IGNORE_N, '\n');
-	in.ignore(IGNORE_N, '\n');
-	in.ignore(IGNORE_N, '\n');
+	if(c != end && (*c == '-' || *c == '+')) neg = (*c++ == '-');
+
+	uint64_t mantissa = 0;
+	int exp10 = 0, n_digits = 0;
+
+	for( ; c != end && is_digit(*c); ++c, ++n_digits)
+	{
+		//keep the 19 most significant digits, drop the rest
+		if(n_digits < 19) mantissa = mantissa*10 + (*c - '0');
+		else exp10++;
+	}
+
+	if(c != end && *c == '.')
+	{
+		for(++c; c != end && is_digit(*c); ++c, ++n_digits)
+		{
+			if(n_digits < 19) { mantissa = mantissa*10 + (*c - '0'); exp10--; }
+		}
+	}
+
+	if(n_digits == 0) return false;
+
+	if(c != end && (*c == 'e' || *c == 'E'))
+	{
+		const char* e = c + 1;
+		long exponent;
+		if(scan_int(e, end, exponent)) { exp10 += exponent; c = e; }
+	}
+
+	double v = (double)mantissa;
+	while(exp10 > 22)  { v *= 1e22; exp10 -= 22; }
+	while(exp10 < -22) { v /= 1e22; exp10 += 22; }
+	v = exp10 >= 0 ? v * POW10[exp10] : v / POW10[-exp10];
+
+	out = neg ? -v : v;
+	p = c;
+	return true;
+}
 
-	while( !in.eof() )
+//Reads the first N_FIELDS numbers of the line starting at P into OUT and
+//moves P to the next line. Returns false for lines with fewer fields
+//(e.g. the empty line at the end of the file), which should be skipped.
+template<typename T, bool (*SCAN)(const char*&, const char*, T&)>
+static bool scan_line(const char*& p, const char* end, T out[], int n_fields)
+{
+	bool ok = true;
+	for(int i = 0; i < n_fields && ok; i++)
 	{
-		std::string buffer;
-		getline(in, buffer);
-		
-		load_vertex(buffer, g);
+		skip_blanks(p, end);
+		ok = SCAN(p, end, out[i]);
 	}
 
-	//Close file
-	in.close();
+	skip_line(p, end);
+	return ok;
+}
+
+//Skips the comment lines of the header and reads the element count
+//from the third line. Returns the count, or 0 if it can't be read
+//(the count is only used as a size hint, so we don't trust it blindly).
+static long scan_header(const char*& p, const char* end)
+{
+	while(p != end && *p == '#') skip_line(p, end);
+
+	long count = 0;
+	skip_blanks(p, end);
+	if(!scan_int(p, end, count) || count < 0) count = 0;
+
+	skip_line(p, end);
+	return count;
 }
 
-static void load_edge(std::string line, Graph& g)
+static bool load_vertice(const std::string& vert, Graph& g, size_t& n_bytes)
 {
-	std::stringstream ss(line);
+	MappedFile file;
+	if(!file.open(vert)) {
+		std::cerr<<"Could not open vertex file "<<vert<<std::endl;
+		return false;
+	}
+
+	const char *p = file.begin(), *end = file.end();
+	n_bytes += file.size();
 
-	int v1, v2, v3;
-	ss>>v1>>v2>>v3;
+	//pre-size node storage using the count in the header (bounded by
+	//the file size, in case the header is broken)
+	g.reserve_nodes( std::min<size_t>(scan_header(p, end), file.size()) );
 
-	//Indexes inside file are 1-index based
-	v1--; v2--; v3--;
+	double v[VERT_FIELDS];
+	while(p != end)
+	{
+		if( scan_line<double, scan_double>(p, end, v, VERT_FIELDS) )
+			g.push_node(v[0], v[1], v[2], v[3], v[4], v[5]);
+	}
 
-	g.push_face(v1, v2, v3);
+	return true;
 }
 
-static void load_edges(std::string face, Graph& g)
+static bool load_edges(const std::string& face, Graph& g, size_t& n_bytes)
 {
-	std::fstream in;
-	in.open(face, std::fstream::in);
+	MappedFile file;
+	if(!file.open(face)) {
+		std::cerr<<"Could not open face file "<<face<<std::endl;
+		return false;
+	}
+
+	const char *p = file.begin(), *end = file.end();
+	n_bytes += file.size();
 
-	//Consume first three lines which are just header info
-	in.ignore(IGNORE_N, '\n');
-	in.ignore(IGNORE_N, '\n');
-	in.ignore(IGNORE_N, '\n');
+	g.reserve_faces( std::min<size_t>(scan_header(p, end), file.size()) );
 
-	while( !in.eof() )
+	long n_nodes = g.size(), skipped = 0;
+	long v[FACE_FIELDS];
+	while(p != end)
 	{
-		std::string buffer;
-		getline(in, buffer);
+		if( !scan_line<long, scan_int>(p, end, v, FACE_FIELDS) ) continue;
 
-		load_edge(buffer, g);
+		//Indexes inside file are 1-index based
+		v[0]--; v[1]--; v[2]--;
+
+		bool valid = true;
+		for(int i = 0; i < FACE_FIELDS; i++)
+			if(v[i] < 0 || v[i] >= n_nodes) valid = false;
+
+		if(valid) g.push_face(v[0], v[1], v[2]);
+		else skipped++;
 	}
 
-	in.close();
+	if(skipped > 0)
+		std::cerr<<"Skipped "<<skipped<<" faces with out-of-range vertices in "<<face<<std::endl;
+
+	return true;
 }
 
 //-----------------------------------------------
 //--------------- FROM FILEIO.H -----------------
 //-----------------------------------------------
-FileIO* FileIO::ptr_instance = NULL;
-
 FileIO::FileIO() { }
 
-void FileIO::mesh_from_file(std::string vert, std::string face, Graph& g)
+bool FileIO::mesh_from_file(const std::string& vert, const std::string& face, Graph& g, LoadStats* stats)
 {
-	load_vertice(vert, g);
-	load_edges(face, g);
-}
\ No newline at end of file
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	size_t n_bytes = 0;
+
+	if( !load_vertice(vert, g, n_bytes) ) return false;
+	if( !load_edges(face, g, n_bytes) ) return false;
+
+	g.build_adjacency();
+
+	if(stats)
+	{
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		stats->bytes = n_bytes;
+		stats->seconds = elapsed.count();
+		stats->from_cache = false;
+	}
+
+	return true;
+}
@@ -0,0 +1,57 @@
+#include "../../inc/io/mapped_file.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+MappedFile::MappedFile() : data(NULL), length(0) { }
+
+MappedFile::~MappedFile()
+{
+	this->close();
+}
+
+bool MappedFile::open(const std::string& path)
+{
+	this->close();
+
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if(fd < 0) return false;
+
+	struct stat st;
+	if(fstat(fd, &st) != 0) { ::close(fd); return false; }
+
+	//mmap refuses zero-length mappings, but an empty file is still a
+	//valid (empty) range, so we point to a static empty buffer instead
+	if(st.st_size == 0)
+	{
+		static const char empty[1] = { 0 };
+		::close(fd);
+		this->data = empty;
+		this->length = 0;
+		return true;
+	}
+
+	void* ptr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	//the mapping holds its own reference to the file
+	::close(fd);
+
+	if(ptr == MAP_FAILED) return false;
+
+	//we'll scan the file front to back exactly once
+	madvise(ptr, st.st_size, MADV_SEQUENTIAL);
+
+	this->data = static_cast<const char*>(ptr);
+	this->length = st.st_size;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if(this->data && this->length > 0)
+		munmap( const_cast<char*>(this->data), this->length );
+
+	this->data = NULL;
+	this->length = 0;
+}
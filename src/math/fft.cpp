@@ -0,0 +1,183 @@
+#include "../../inc/math/fft.h"
+#include <cmath>
+#include <algorithm>
+#include <glm/gtc/constants.hpp>
+
+typedef std::complex<double> Complex;
+
+//------------------------------------------------------
+//--------------------- INTERNAL -----------------------
+//------------------------------------------------------
+static const int RADIXES[] = { 4, 2, 3, 5 };
+static const int MAX_RADIX = 5;
+
+//Lines transformed together in the strided passes
+static const int BLOCK = 8;
+
+//Plain complex product: operator* goes through a library call
+//handling infinities and NaNs, which is far slower
+static inline Complex mul(const Complex& a, const Complex& b)
+{
+	return Complex(a.real()*b.real() - a.imag()*b.imag(), a.real()*b.imag() + a.imag()*b.real());
+}
+
+static bool all_zero(const Complex* line, int n)
+{
+	for(int i = 0; i < n; i++)
+		if(line[i] != 0.0) return false;
+	return true;
+}
+
+//-----------------------------------------------
+//----------------- FROM FFT.H ------------------
+//-----------------------------------------------
+int next_fft_size(int n)
+{
+	for(int m = std::max(n, 1); ; m++)
+	{
+		int r = m;
+		for(int p = 2; p <= 5; p++)
+			while(r % p == 0) r /= p;
+		if(r == 1) return m;
+	}
+}
+
+FFTPlan::FFTPlan(int n) : n(n), twiddles(n), inverse_twiddles(n)
+{
+	int r = n;
+	for(int f = 0; f < 4; f++)
+		while(r % RADIXES[f] == 0)
+		{
+			factors.push_back(RADIXES[f]);
+			r /= RADIXES[f];
+		}
+
+	for(int k = 0; k < n; k++)
+	{
+		double angle = -2.0 * glm::pi<double>() * k / n;
+		twiddles[k] = Complex(cos(angle), sin(angle));
+		inverse_twiddles[k] = std::conj(twiddles[k]);
+	}
+}
+
+// The N inputs split into P interleaved sequences (P the radix of this
+// LEVEL), whose DFTs of size M = N/P are computed first, each into its
+// block of OUT. Output s*M + k is then the DFT of size P of the outputs k
+// of every block, each one twiddled by w_N^(q*k). Since every level
+// multiplies the stride by its radix, w_N is the STRIDE-th power of w_n
+// (n the size of the plan), which is how twiddles are looked up.
+void FFTPlan::transform_step(Complex* out, const Complex* in, int n, int stride, int level, bool inverse) const
+{
+	const int p = factors[level], m = n / p;
+
+	//the last level reads its inputs straight from IN
+	if(m == 1) for(int q = 0; q < p; q++) out[q] = in[q*stride];
+	else
+		for(int q = 0; q < p; q++)
+			transform_step(out + q*m, in + q*stride, m, stride*p, level + 1, inverse);
+
+	const Complex* tw = inverse ? inverse_twiddles.data() : twiddles.data();
+
+	//-i for forward transforms, i for inverse ones
+	const Complex minus_i = inverse ? Complex(0.0, 1.0) : Complex(0.0, -1.0);
+
+	//DFT matrix of size P: w_p^(q*s) = w_n^(q*s*n/p)
+	Complex dft[MAX_RADIX][MAX_RADIX];
+	if(p != 2 && p != 4)
+		for(int s = 0; s < p; s++)
+			for(int q = 0; q < p; q++)
+				dft[s][q] = tw[ (q*s % p) * (this->n / p) ];
+
+	for(int k = 0; k < m; k++)
+	{
+		Complex v[MAX_RADIX];
+		v[0] = out[k];
+		for(int q = 1; q < p; q++) v[q] = mul(out[q*m + k], tw[q*k*stride]);
+
+		if(p == 2)
+		{
+			out[k] = v[0] + v[1];
+			out[k + m] = v[0] - v[1];
+		}
+		else if(p == 4)
+		{
+			Complex a = v[0] + v[2], b = v[0] - v[2];
+			Complex c = v[1] + v[3], d = mul(v[1] - v[3], minus_i);
+
+			out[k] = a + c;
+			out[k + m] = b + d;
+			out[k + 2*m] = a - c;
+			out[k + 3*m] = b - d;
+		}
+		else
+		{
+			for(int s = 0; s < p; s++)
+			{
+				Complex acc = v[0];
+				for(int q = 1; q < p; q++) acc += mul(v[q], dft[s][q]);
+				out[s*m + k] = acc;
+			}
+		}
+	}
+}
+
+void FFTPlan::transform_line(Complex* line, Complex* scratch, bool inverse) const
+{
+	//a single value is its own transform
+	if(factors.empty()) return;
+
+	std::copy(line, line + n, scratch);
+	transform_step(line, scratch, n, 1, 0, inverse);
+}
+
+//Transforms the lines along x in place, then the lines along y and z
+//through contiguous copies. Those are BLOCK lines at a time, of BLOCK
+//consecutive x, so that every cache line of the grid is read whole.
+//Lines of zeros transform to zeros, so they are skipped: a grid with
+//few nonzero nodes (like a small molecule in a large box) costs much
+//less than a full transform.
+void FFTPlan::transform(Complex* grid, bool inverse) const
+{
+	const size_t sy = n, sz = (size_t)n*n;
+	std::vector<Complex> lines(BLOCK*n), scratch(n);
+
+	for(size_t l = 0; l < sz; l++)
+		if(!all_zero(grid + l*n, n)) transform_line(grid + l*n, scratch.data(), inverse);
+
+	//lines along y (stride sy) for every z, then along z (stride sz)
+	//for every y; OUTER is the other coordinate
+	for(int pass = 0; pass < 2; pass++)
+	{
+		const size_t stride = pass == 0 ? sy : sz, outer = pass == 0 ? sz : sy;
+
+		for(int o = 0; o < n; o++)
+			for(int x0 = 0; x0 < n; x0 += BLOCK)
+			{
+				const int width = std::min(BLOCK, n - x0);
+				Complex* first = grid + x0 + outer*o;
+
+				for(int i = 0; i < n; i++)
+					for(int b = 0; b < width; b++) lines[b*n + i] = first[stride*i + b];
+
+				for(int b = 0; b < width; b++)
+					if(!all_zero(&lines[b*n], n)) transform_line(&lines[b*n], scratch.data(), inverse);
+
+				for(int i = 0; i < n; i++)
+					for(int b = 0; b < width; b++) first[stride*i + b] = lines[b*n + i];
+			}
+	}
+}
+
+void FFTPlan::forward(Complex* grid) const
+{
+	transform(grid, false);
+}
+
+void FFTPlan::inverse(Complex* grid) const
+{
+	transform(grid, true);
+
+	const size_t total = (size_t)n*n*n;
+	const double scale = 1.0 / total;
+	for(size_t i = 0; i < total; i++) grid[i] *= scale;
+}
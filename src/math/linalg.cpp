@@ -6,11 +6,44 @@ glm::dvec3 triangle_centroid(const glm::dvec3& p1, const glm::dvec3& p2, const g
 	return sum / 3.0;
 }
 
-glm::dvec3 cloud_centroid(const std::vector<glm::dvec3>& cloud)
+glm::dvec3 cloud_centroid(ConstSpan<glm::dvec3> cloud)
 {
 	glm::dvec3 sum = glm::dvec3(0,0,0);
 	for(auto it = cloud.begin(); it != cloud.end(); ++it)
 		sum += (*it);
 
 	return sum / (double)cloud.size();
+}
+
+glm::dmat3 optimal_rotation(const double m[3][3])
+{
+	const double sxx = m[0][0], sxy = m[0][1], sxz = m[0][2];
+	const double syx = m[1][0], syy = m[1][1], syz = m[1][2];
+	const double szx = m[2][0], szy = m[2][1], szz = m[2][2];
+
+	//Horn (1987): the quaternion (w, x, y, z) maximises q^T N q
+	double n[4][4] = {
+		{ sxx + syy + szz,	syz - szy,			szx - sxz,			sxy - syx },
+		{ syz - szy,		sxx - syy - szz,	sxy + syx,			szx + sxz },
+		{ szx - sxz,		sxy + syx,			-sxx + syy - szz,	syz + szy },
+		{ sxy - syx,		szx + sxz,			syz + szy,			-sxx - syy + szz }
+	};
+
+	double eval[4], evec[4][4];
+	symmetric_eigen<4>(n, eval, evec);
+
+	int best = 0;
+	for(int i = 1; i < 4; i++)
+		if(eval[i] > eval[best]) best = i;
+
+	double w = evec[0][best], x = evec[1][best], y = evec[2][best], z = evec[3][best];
+	double len = sqrt(w*w + x*x + y*y + z*z);
+	w /= len; x /= len; y /= len; z /= len;
+
+	//glm matrices are column-major: r[col][row]
+	glm::dmat3 r;
+	r[0][0] = 1.0 - 2.0*(y*y + z*z);	r[1][0] = 2.0*(x*y - w*z);			r[2][0] = 2.0*(x*z + w*y);
+	r[0][1] = 2.0*(x*y + w*z);			r[1][1] = 1.0 - 2.0*(x*x + z*z);	r[2][1] = 2.0*(y*z - w*x);
+	r[0][2] = 2.0*(x*z - w*y);			r[1][2] = 2.0*(y*z + w*x);			r[2][2] = 1.0 - 2.0*(x*x + y*y);
+	return r;
 }
\ No newline at end of file
@@ -0,0 +1,681 @@
+#include "../../inc/math/simd_kernels.h"
+#include "../../inc/math/linalg.h"
+#include "../../inc/parameters.h"
+#include <cmath>
+#include <algorithm>
+
+//GCC fuses multiplies and adds into FMAs whenever the target has them
+//(AVX-512 does), which would make the paths round differently
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+//------------------------------------------
+//--------------- INTERNAL -----------------
+//------------------------------------------
+// The vector versions mirror the scalar ones operation by operation.
+// Don't introduce FMAs or reassociate sums in only one of them: the
+// point of keeping them in lockstep is that results don't depend on
+// the CPU. Tails that don't fill a whole vector use the scalar version.
+
+static const double PI = 3.14159265358979323846;
+
+//Abramowitz & Stegun 4.4.46, |error| <= 2.2e-8 as tabulated
+static const double ACOS_A[8] = {
+	 1.5707963050, -0.2145988016,  0.0889789874, -0.0501743046,
+	 0.0308918810, -0.0170881256,  0.0066700901, -0.0012624911
+};
+
+static inline void corner_scalar(const double* P, const double* Q1, const double* Q2, const double U[3], double* out)
+{
+	double ux = U[0] - P[0], uy = U[1] - P[1], uz = U[2] - P[2];
+	double q1x = Q1[0] - P[0], q1y = Q1[1] - P[1], q1z = Q1[2] - P[2];
+	double q2x = Q2[0] - P[0], q2y = Q2[1] - P[1], q2z = Q2[2] - P[2];
+
+	double dot = q1x*q2x + q1y*q2y + q1z*q2z;
+	double l1 = sqrt(q1x*q1x + q1y*q1y + q1z*q1z);
+	double l2 = sqrt(q2x*q2x + q2y*q2y + q2z*q2z);
+	double alpha = approx_acos( dot / (l1*l2) );
+
+	double lu = sqrt(ux*ux + uy*uy + uz*uz);
+	out[0] = alpha * (ux / lu);
+	out[1] = alpha * (uy / lu);
+	out[2] = alpha * (uz / lu);
+}
+
+static void corner_curvatures_scalar(const double* positions, const int* faces, int begin, int end, double* out)
+{
+	for(int f = begin; f < end; f++)
+	{
+		const double *A = positions + 3*faces[3*f], *B = positions + 3*faces[3*f + 1], *C = positions + 3*faces[3*f + 2];
+		double U[3] = { (A[0] + B[0] + C[0]) / 3.0, (A[1] + B[1] + C[1]) / 3.0, (A[2] + B[2] + C[2]) / 3.0 };
+
+		corner_scalar(A, B, C, U, out + 9*f);
+		corner_scalar(B, C, A, U, out + 9*f + 3);
+		corner_scalar(C, A, B, U, out + 9*f + 6);
+	}
+}
+
+static inline Convexity convexity_scalar(double dot)
+{
+	if( d_equals(dot, 0.0) ) return FLAT;
+	return dot > 0 ? CONVEX : CONCAVE;
+}
+
+static void classify_convexity_scalar(const double* positions, const double* curvatures, const double centroid[3],
+									  int begin, int end, Convexity* types)
+{
+	for(int i = begin; i < end; i++)
+	{
+		const double *p = positions + 3*i, *k = curvatures + 3*i;
+		double dot = (centroid[0] - p[0])*k[0] + (centroid[1] - p[1])*k[1] + (centroid[2] - p[2])*k[2];
+		types[i] = convexity_scalar(dot);
+	}
+}
+
+//Points per block of transform_points(): 128 positions and normals
+//(6 KB) stay in L1 while the poses go through them
+static const int TRANSFORM_BLOCK = 128;
+
+//M (column-major 4x4) applied to points [begin, end) of IN, with its
+//translation if TRANSLATE (positions) or without (normals). The sums go
+//left to right, as glm's c0*x + c1*y + c2*z + t does.
+static void transform_scalar(const double* in, int begin, int end, const double* m, bool translate, double* out)
+{
+	for(int i = begin; i < end; i++)
+	{
+		const double* p = in + 3*i;
+		double* o = out + 3*(i - begin);
+		for(int c = 0; c < 3; c++)
+		{
+			double v = m[c]*p[0] + m[4 + c]*p[1] + m[8 + c]*p[2];
+			o[c] = translate ? v + m[12 + c] : v;
+		}
+	}
+}
+
+//Same with fused multiply-adds, m2*p2 + (m1*p1 + m0*p0): the tails of
+//the fused vector versions, so that those agree with each other
+static void transform_fused_scalar(const double* in, int begin, int end, const double* m, bool translate, double* out)
+{
+	for(int i = begin; i < end; i++)
+	{
+		const double* p = in + 3*i;
+		double* o = out + 3*(i - begin);
+		for(int c = 0; c < 3; c++)
+		{
+			double v = fma(m[8 + c], p[2], fma(m[4 + c], p[1], m[c]*p[0]));
+			o[c] = translate ? v + m[12 + c] : v;
+		}
+	}
+}
+
+typedef void (*TransformKernel)(const double*, int, int, const double*, bool, double*);
+
+#ifdef SIMD_X86
+
+//------------------ AVX2 ------------------
+
+//Gathers of every lane. They go through the masked forms with a zeroed
+//source: the plain ones leave their source undefined, which GCC warns
+//about (-Wmaybe-uninitialized) at -O2
+__attribute__((target("avx2")))
+static inline __m128i gather_epi32_avx2(const int* base, __m128i idx)
+{
+	return _mm_mask_i32gather_epi32(_mm_setzero_si128(), base, idx, _mm_set1_epi32(-1), 4);
+}
+
+__attribute__((target("avx2")))
+static inline __m256d gather_pd_avx2(const double* base, __m128i idx)
+{
+	const __m256d all = _mm256_castsi256_pd( _mm256_set1_epi64x(-1) );
+	return _mm256_mask_i32gather_pd(_mm256_setzero_pd(), base, idx, all, 8);
+}
+
+__attribute__((target("avx2")))
+static inline __m256d acos_avx2(__m256d x)
+{
+	//max/min return their second operand on NaN, so NaN goes through
+	x = _mm256_min_pd( _mm256_set1_pd(1.0), _mm256_max_pd(_mm256_set1_pd(-1.0), x) );
+	__m256d ax = _mm256_andnot_pd(_mm256_set1_pd(-0.0), x);
+
+	__m256d p = _mm256_set1_pd(ACOS_A[7]);
+	for(int i = 6; i >= 0; i--)
+		p = _mm256_add_pd( _mm256_mul_pd(p, ax), _mm256_set1_pd(ACOS_A[i]) );
+
+	__m256d r = _mm256_mul_pd( _mm256_sqrt_pd(_mm256_sub_pd(_mm256_set1_pd(1.0), ax)), p );
+	__m256d neg = _mm256_cmp_pd(x, _mm256_setzero_pd(), _CMP_LT_OQ);
+	return _mm256_blendv_pd( r, _mm256_sub_pd(_mm256_set1_pd(PI), r), neg );
+}
+
+__attribute__((target("avx2")))
+static inline __m256d dot_avx2(__m256d ax, __m256d ay, __m256d az, __m256d bx, __m256d by, __m256d bz)
+{
+	return _mm256_add_pd( _mm256_add_pd(_mm256_mul_pd(ax, bx), _mm256_mul_pd(ay, by)), _mm256_mul_pd(az, bz) );
+}
+
+__attribute__((target("avx2")))
+static inline void corner_avx2(const __m256d P[3], const __m256d Q1[3], const __m256d Q2[3], const __m256d U[3], __m256d out[3])
+{
+	__m256d u[3], q1[3], q2[3];
+	for(int c = 0; c < 3; c++)
+	{
+		u[c] = _mm256_sub_pd(U[c], P[c]);
+		q1[c] = _mm256_sub_pd(Q1[c], P[c]);
+		q2[c] = _mm256_sub_pd(Q2[c], P[c]);
+	}
+
+	__m256d dot = dot_avx2(q1[0], q1[1], q1[2], q2[0], q2[1], q2[2]);
+	__m256d l1 = _mm256_sqrt_pd( dot_avx2(q1[0], q1[1], q1[2], q1[0], q1[1], q1[2]) );
+	__m256d l2 = _mm256_sqrt_pd( dot_avx2(q2[0], q2[1], q2[2], q2[0], q2[1], q2[2]) );
+	__m256d alpha = acos_avx2( _mm256_div_pd(dot, _mm256_mul_pd(l1, l2)) );
+
+	__m256d lu = _mm256_sqrt_pd( dot_avx2(u[0], u[1], u[2], u[0], u[1], u[2]) );
+	for(int c = 0; c < 3; c++)
+		out[c] = _mm256_mul_pd( alpha, _mm256_div_pd(u[c], lu) );
+}
+
+//Writes corner K of the 4 faces starting at F
+__attribute__((target("avx2")))
+static inline void store_corner_avx2(const __m256d v[3], int f, int k, double* out)
+{
+	double lanes[3][4];
+	for(int c = 0; c < 3; c++) _mm256_storeu_pd(lanes[c], v[c]);
+
+	for(int j = 0; j < 4; j++)
+		for(int c = 0; c < 3; c++)
+			out[ 3*(3*(f + j) + k) + c ] = lanes[c][j];
+}
+
+__attribute__((target("avx2")))
+static void corner_curvatures_avx2(const double* positions, const int* faces, int begin, int end, double* out)
+{
+	const __m128i stride = _mm_setr_epi32(0, 3, 6, 9);
+	const __m128i three = _mm_set1_epi32(3);
+	const __m256d third = _mm256_set1_pd(3.0);
+
+	int f = begin;
+	for( ; f + 4 <= end; f += 4)
+	{
+		//V[k][c]: coordinate c of corner k of the 4 faces
+		__m256d V[3][3];
+		for(int k = 0; k < 3; k++)
+		{
+			__m128i idx = _mm_mullo_epi32( gather_epi32_avx2(faces + 3*f + k, stride), three );
+			for(int c = 0; c < 3; c++)
+				V[k][c] = gather_pd_avx2(positions + c, idx);
+		}
+
+		__m256d U[3];
+		for(int c = 0; c < 3; c++)
+			U[c] = _mm256_div_pd( _mm256_add_pd(_mm256_add_pd(V[0][c], V[1][c]), V[2][c]), third );
+
+		__m256d res[3];
+		for(int k = 0; k < 3; k++)
+		{
+			corner_avx2(V[k], V[(k+1) % 3], V[(k+2) % 3], U, res);
+			store_corner_avx2(res, f, k, out);
+		}
+	}
+
+	corner_curvatures_scalar(positions, faces, f, end, out);
+}
+
+__attribute__((target("avx2")))
+static void classify_convexity_avx2(const double* positions, const double* curvatures, const double centroid[3],
+									int begin, int end, Convexity* types)
+{
+	const __m128i stride = _mm_setr_epi32(0, 3, 6, 9);
+	const __m256d eps = _mm256_set1_pd(EPS), zero = _mm256_setzero_pd(), sign = _mm256_set1_pd(-0.0);
+	__m256d c[3] = { _mm256_set1_pd(centroid[0]), _mm256_set1_pd(centroid[1]), _mm256_set1_pd(centroid[2]) };
+
+	int i = begin;
+	for( ; i + 4 <= end; i += 4)
+	{
+		__m256d v[3], k[3];
+		for(int j = 0; j < 3; j++)
+		{
+			v[j] = _mm256_sub_pd( c[j], gather_pd_avx2(positions + 3*i + j, stride) );
+			k[j] = gather_pd_avx2(curvatures + 3*i + j, stride);
+		}
+
+		__m256d dot = dot_avx2(v[0], v[1], v[2], k[0], k[1], k[2]);
+		int flat = _mm256_movemask_pd( _mm256_cmp_pd(_mm256_andnot_pd(sign, dot), eps, _CMP_LE_OQ) );
+		int convex = _mm256_movemask_pd( _mm256_cmp_pd(dot, zero, _CMP_GT_OQ) );
+
+		for(int j = 0; j < 4; j++)
+			types[i + j] = (flat >> j) & 1 ? FLAT : ((convex >> j) & 1 ? CONVEX : CONCAVE);
+	}
+
+	classify_convexity_scalar(positions, curvatures, centroid, i, end, types);
+}
+
+//Packed triples of 4 points (12 doubles) to/from one vector per
+//coordinate, with in-lane shuffles instead of gathers and scatters
+__attribute__((target("avx2")))
+static inline void load_triples_avx2(const double* in, __m256d v[3])
+{
+	__m256d r0 = _mm256_loadu_pd(in), r1 = _mm256_loadu_pd(in + 4), r2 = _mm256_loadu_pd(in + 8);
+
+	__m256d a = _mm256_blend_pd(r0, r1, 0xC);				//x0 y0 | x2 y2
+	__m256d b = _mm256_permute2f128_pd(r0, r2, 0x21);		//z0 x1 | z2 x3
+	__m256d c = _mm256_blend_pd(r1, r2, 0xC);				//y1 z1 | y3 z3
+
+	v[0] = _mm256_blend_pd(a, b, 0xA);
+	v[1] = _mm256_shuffle_pd(a, c, 0x5);
+	v[2] = _mm256_blend_pd(b, c, 0xA);
+}
+
+__attribute__((target("avx2")))
+static inline void store_triples_avx2(const __m256d v[3], double* out)
+{
+	__m256d a = _mm256_unpacklo_pd(v[0], v[1]);				//x0 y0 | x2 y2
+	__m256d b = _mm256_blend_pd(v[2], v[0], 0xA);			//z0 x1 | z2 x3
+	__m256d c = _mm256_unpackhi_pd(v[1], v[2]);				//y1 z1 | y3 z3
+
+	_mm256_storeu_pd(out, _mm256_permute2f128_pd(a, b, 0x20));
+	_mm256_storeu_pd(out + 4, _mm256_permute2f128_pd(c, a, 0x30));
+	_mm256_storeu_pd(out + 8, _mm256_permute2f128_pd(b, c, 0x31));
+}
+
+__attribute__((target("avx2")))
+static void transform_avx2(const double* in, int begin, int end, const double* m, bool translate, double* out)
+{
+	__m256d col[4][3];
+	for(int j = 0; j < 4; j++)
+		for(int c = 0; c < 3; c++) col[j][c] = _mm256_set1_pd(m[4*j + c]);
+
+	int i = begin;
+	for( ; i + 4 <= end; i += 4)
+	{
+		__m256d p[3], v[3];
+		load_triples_avx2(in + 3*i, p);
+
+		for(int c = 0; c < 3; c++)
+		{
+			v[c] = _mm256_add_pd( _mm256_add_pd(_mm256_mul_pd(col[0][c], p[0]), _mm256_mul_pd(col[1][c], p[1])),
+								  _mm256_mul_pd(col[2][c], p[2]) );
+			if(translate) v[c] = _mm256_add_pd(v[c], col[3][c]);
+		}
+
+		store_triples_avx2(v, out + 3*(i - begin));
+	}
+
+	transform_scalar(in, i, end, m, translate, out + 3*(i - begin));
+}
+
+//Fused version of transform_avx2() (Parameters::FUSED_TRANSFORMS), for
+//CPUs with FMA: it does not mirror the scalar one
+__attribute__((target("avx2,fma")))
+static void transform_fused_avx2(const double* in, int begin, int end, const double* m, bool translate, double* out)
+{
+	__m256d col[4][3];
+	for(int j = 0; j < 4; j++)
+		for(int c = 0; c < 3; c++) col[j][c] = _mm256_set1_pd(m[4*j + c]);
+
+	int i = begin;
+	for( ; i + 4 <= end; i += 4)
+	{
+		__m256d p[3], v[3];
+		load_triples_avx2(in + 3*i, p);
+
+		for(int c = 0; c < 3; c++)
+		{
+			v[c] = _mm256_fmadd_pd(col[2][c], p[2], _mm256_fmadd_pd(col[1][c], p[1], _mm256_mul_pd(col[0][c], p[0])));
+			if(translate) v[c] = _mm256_add_pd(v[c], col[3][c]);
+		}
+
+		store_triples_avx2(v, out + 3*(i - begin));
+	}
+
+	transform_fused_scalar(in, i, end, m, translate, out + 3*(i - begin));
+}
+
+//----------------- AVX-512 ----------------
+
+__attribute__((target("avx512f")))
+static inline __m256i gather_epi32_avx512(const int* base, __m256i idx)
+{
+	return _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), base, idx, _mm256_set1_epi32(-1), 4);
+}
+
+__attribute__((target("avx512f")))
+static inline __m512d gather_pd_avx512(const double* base, __m256i idx)
+{
+	return _mm512_mask_i32gather_pd(_mm512_setzero_pd(), 0xFF, idx, base, 8);
+}
+
+//GCC builds the unmasked sqrt, min and max on an undefined source as well
+__attribute__((target("avx512f")))
+static inline __m512d sqrt_avx512(__m512d x)
+{
+	return _mm512_mask_sqrt_pd(_mm512_setzero_pd(), 0xFF, x);
+}
+
+__attribute__((target("avx512f")))
+static inline __m512d min_avx512(__m512d a, __m512d b)
+{
+	return _mm512_mask_min_pd(_mm512_setzero_pd(), 0xFF, a, b);
+}
+
+__attribute__((target("avx512f")))
+static inline __m512d max_avx512(__m512d a, __m512d b)
+{
+	return _mm512_mask_max_pd(_mm512_setzero_pd(), 0xFF, a, b);
+}
+
+__attribute__((target("avx512f")))
+static inline __m512d acos_avx512(__m512d x)
+{
+	x = min_avx512( _mm512_set1_pd(1.0), max_avx512(_mm512_set1_pd(-1.0), x) );
+	__m512d ax = _mm512_abs_pd(x);
+
+	__m512d p = _mm512_set1_pd(ACOS_A[7]);
+	for(int i = 6; i >= 0; i--)
+		p = _mm512_add_pd( _mm512_mul_pd(p, ax), _mm512_set1_pd(ACOS_A[i]) );
+
+	__m512d r = _mm512_mul_pd( sqrt_avx512(_mm512_sub_pd(_mm512_set1_pd(1.0), ax)), p );
+	__mmask8 neg = _mm512_cmp_pd_mask(x, _mm512_setzero_pd(), _CMP_LT_OQ);
+	return _mm512_mask_blend_pd( neg, r, _mm512_sub_pd(_mm512_set1_pd(PI), r) );
+}
+
+__attribute__((target("avx512f")))
+static inline __m512d dot_avx512(__m512d ax, __m512d ay, __m512d az, __m512d bx, __m512d by, __m512d bz)
+{
+	return _mm512_add_pd( _mm512_add_pd(_mm512_mul_pd(ax, bx), _mm512_mul_pd(ay, by)), _mm512_mul_pd(az, bz) );
+}
+
+__attribute__((target("avx512f")))
+static inline void corner_avx512(const __m512d P[3], const __m512d Q1[3], const __m512d Q2[3], const __m512d U[3], __m512d out[3])
+{
+	__m512d u[3], q1[3], q2[3];
+	for(int c = 0; c < 3; c++)
+	{
+		u[c] = _mm512_sub_pd(U[c], P[c]);
+		q1[c] = _mm512_sub_pd(Q1[c], P[c]);
+		q2[c] = _mm512_sub_pd(Q2[c], P[c]);
+	}
+
+	__m512d dot = dot_avx512(q1[0], q1[1], q1[2], q2[0], q2[1], q2[2]);
+	__m512d l1 = sqrt_avx512( dot_avx512(q1[0], q1[1], q1[2], q1[0], q1[1], q1[2]) );
+	__m512d l2 = sqrt_avx512( dot_avx512(q2[0], q2[1], q2[2], q2[0], q2[1], q2[2]) );
+	__m512d alpha = acos_avx512( _mm512_div_pd(dot, _mm512_mul_pd(l1, l2)) );
+
+	__m512d lu = sqrt_avx512( dot_avx512(u[0], u[1], u[2], u[0], u[1], u[2]) );
+	for(int c = 0; c < 3; c++)
+		out[c] = _mm512_mul_pd( alpha, _mm512_div_pd(u[c], lu) );
+}
+
+//Writes corner K of the 8 faces starting at F
+__attribute__((target("avx512f")))
+static inline void store_corner_avx512(const __m512d v[3], int f, int k, double* out)
+{
+	double lanes[3][8];
+	for(int c = 0; c < 3; c++) _mm512_storeu_pd(lanes[c], v[c]);
+
+	for(int j = 0; j < 8; j++)
+		for(int c = 0; c < 3; c++)
+			out[ 3*(3*(f + j) + k) + c ] = lanes[c][j];
+}
+
+__attribute__((target("avx512f")))
+static void corner_curvatures_avx512(const double* positions, const int* faces, int begin, int end, double* out)
+{
+	const __m256i stride = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+	const __m256i three = _mm256_set1_epi32(3);
+	const __m512d third = _mm512_set1_pd(3.0);
+
+	int f = begin;
+	for( ; f + 8 <= end; f += 8)
+	{
+		__m512d V[3][3];
+		for(int k = 0; k < 3; k++)
+		{
+			__m256i idx = _mm256_mullo_epi32( gather_epi32_avx512(faces + 3*f + k, stride), three );
+			for(int c = 0; c < 3; c++)
+				V[k][c] = gather_pd_avx512(positions + c, idx);
+		}
+
+		__m512d U[3];
+		for(int c = 0; c < 3; c++)
+			U[c] = _mm512_div_pd( _mm512_add_pd(_mm512_add_pd(V[0][c], V[1][c]), V[2][c]), third );
+
+		__m512d res[3];
+		for(int k = 0; k < 3; k++)
+		{
+			corner_avx512(V[k], V[(k+1) % 3], V[(k+2) % 3], U, res);
+			store_corner_avx512(res, f, k, out);
+		}
+	}
+
+	corner_curvatures_scalar(positions, faces, f, end, out);
+}
+
+__attribute__((target("avx512f")))
+static void classify_convexity_avx512(const double* positions, const double* curvatures, const double centroid[3],
+									  int begin, int end, Convexity* types)
+{
+	const __m256i stride = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+	const __m512d eps = _mm512_set1_pd(EPS), zero = _mm512_setzero_pd();
+	__m512d c[3] = { _mm512_set1_pd(centroid[0]), _mm512_set1_pd(centroid[1]), _mm512_set1_pd(centroid[2]) };
+
+	int i = begin;
+	for( ; i + 8 <= end; i += 8)
+	{
+		__m512d v[3], k[3];
+		for(int j = 0; j < 3; j++)
+		{
+			v[j] = _mm512_sub_pd( c[j], gather_pd_avx512(positions + 3*i + j, stride) );
+			k[j] = gather_pd_avx512(curvatures + 3*i + j, stride);
+		}
+
+		__m512d dot = dot_avx512(v[0], v[1], v[2], k[0], k[1], k[2]);
+		__mmask8 flat = _mm512_cmp_pd_mask(_mm512_abs_pd(dot), eps, _CMP_LE_OQ);
+		__mmask8 convex = _mm512_cmp_pd_mask(dot, zero, _CMP_GT_OQ);
+
+		for(int j = 0; j < 8; j++)
+			types[i + j] = (flat >> j) & 1 ? FLAT : ((convex >> j) & 1 ? CONVEX : CONCAVE);
+	}
+
+	classify_convexity_scalar(positions, curvatures, centroid, i, end, types);
+}
+
+//Same for 8 points (24 doubles), with two-source permutes: coordinate
+//C of point K is element 3*K + C of the three vectors R0 R1 R2
+__attribute__((target("avx512f")))
+static inline void load_triples_avx512(const double* in, __m512d v[3])
+{
+	__m512d r0 = _mm512_loadu_pd(in), r1 = _mm512_loadu_pd(in + 8), r2 = _mm512_loadu_pd(in + 16);
+
+	//first the elements in R0 R1 (< 16), then the ones in R2
+	static const long long lo[3][8] = { { 0, 3, 6, 9, 12, 15, 0, 0 }, { 1, 4, 7, 10, 13, 0, 0, 0 }, { 2, 5, 8, 11, 14, 0, 0, 0 } };
+	static const long long hi[3][8] = { { 0, 1, 2, 3, 4, 5, 10, 13 }, { 0, 1, 2, 3, 4, 8, 11, 14 }, { 0, 1, 2, 3, 4, 9, 12, 15 } };
+	for(int c = 0; c < 3; c++)
+	{
+		__m512d t = _mm512_permutex2var_pd(r0, _mm512_loadu_si512(lo[c]), r1);
+		v[c] = _mm512_permutex2var_pd(t, _mm512_loadu_si512(hi[c]), r2);
+	}
+}
+
+__attribute__((target("avx512f")))
+static inline void store_triples_avx512(const __m512d v[3], double* out)
+{
+	//element E of output vector J is coordinate (8J + E) % 3 of point
+	//(8J + E) / 3: first X and Y, then Z
+	static const long long xy[3][8] = { { 0, 8, 0, 1, 9, 0, 2, 10 }, { 0, 3, 11, 0, 4, 12, 0, 5 }, { 13, 0, 6, 14, 0, 7, 15, 0 } };
+	static const long long z[3][8] = { { 0, 1, 8, 3, 4, 9, 6, 7 }, { 10, 1, 2, 11, 4, 5, 12, 7 }, { 0, 13, 2, 3, 14, 5, 6, 15 } };
+	for(int j = 0; j < 3; j++)
+	{
+		__m512d t = _mm512_permutex2var_pd(v[0], _mm512_loadu_si512(xy[j]), v[1]);
+		_mm512_storeu_pd(out + 8*j, _mm512_permutex2var_pd(t, _mm512_loadu_si512(z[j]), v[2]));
+	}
+}
+
+__attribute__((target("avx512f")))
+static void transform_avx512(const double* in, int begin, int end, const double* m, bool translate, double* out)
+{
+	__m512d col[4][3];
+	for(int j = 0; j < 4; j++)
+		for(int c = 0; c < 3; c++) col[j][c] = _mm512_set1_pd(m[4*j + c]);
+
+	int i = begin;
+	for( ; i + 8 <= end; i += 8)
+	{
+		__m512d p[3], v[3];
+		load_triples_avx512(in + 3*i, p);
+
+		for(int c = 0; c < 3; c++)
+		{
+			v[c] = _mm512_add_pd( _mm512_add_pd(_mm512_mul_pd(col[0][c], p[0]), _mm512_mul_pd(col[1][c], p[1])),
+								  _mm512_mul_pd(col[2][c], p[2]) );
+			if(translate) v[c] = _mm512_add_pd(v[c], col[3][c]);
+		}
+
+		store_triples_avx512(v, out + 3*(i - begin));
+	}
+
+	transform_scalar(in, i, end, m, translate, out + 3*(i - begin));
+}
+
+//Fused version of transform_avx512(): AVX-512F has FMA
+__attribute__((target("avx512f")))
+static void transform_fused_avx512(const double* in, int begin, int end, const double* m, bool translate, double* out)
+{
+	__m512d col[4][3];
+	for(int j = 0; j < 4; j++)
+		for(int c = 0; c < 3; c++) col[j][c] = _mm512_set1_pd(m[4*j + c]);
+
+	int i = begin;
+	for( ; i + 8 <= end; i += 8)
+	{
+		__m512d p[3], v[3];
+		load_triples_avx512(in + 3*i, p);
+
+		for(int c = 0; c < 3; c++)
+		{
+			v[c] = _mm512_fmadd_pd(col[2][c], p[2], _mm512_fmadd_pd(col[1][c], p[1], _mm512_mul_pd(col[0][c], p[0])));
+			if(translate) v[c] = _mm512_add_pd(v[c], col[3][c]);
+		}
+
+		store_triples_avx512(v, out + 3*(i - begin));
+	}
+
+	transform_fused_scalar(in, i, end, m, translate, out + 3*(i - begin));
+}
+
+#endif //SIMD_X86
+
+static SimdLevel cpu_simd_level()
+{
+#ifdef SIMD_X86
+	__builtin_cpu_init();
+	if( __builtin_cpu_supports("avx512f") ) return SIMD_AVX512;
+	if( __builtin_cpu_supports("avx2") ) return SIMD_AVX2;
+#endif
+	return SIMD_SCALAR;
+}
+
+#ifdef SIMD_X86
+static bool cpu_has_fma()
+{
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("fma");
+}
+
+//The fused kernels, if they were asked for and the CPU has them
+static bool use_fused(SimdLevel level)
+{
+	static const bool fma = cpu_has_fma();
+	return Parameters::FUSED_TRANSFORMS && (level == SIMD_AVX512 || fma);
+}
+#endif
+
+//-----------------------------------------------------
+//--------------- FROM SIMD_KERNELS.H -----------------
+//-----------------------------------------------------
+SimdLevel simd_level()
+{
+	static const SimdLevel cpu = cpu_simd_level();
+	return (SimdLevel) std::min( std::max(Parameters::SIMD_LEVEL, 0), (int)cpu );
+}
+
+const char* simd_level_name(SimdLevel level)
+{
+	switch(level)
+	{
+		case SIMD_AVX512: return "AVX-512";
+		case SIMD_AVX2: return "AVX2";
+		default: return "scalar";
+	}
+}
+
+double approx_acos(double x)
+{
+	if(x < -1.0) x = -1.0;
+	else if(x > 1.0) x = 1.0;
+	double ax = fabs(x);
+
+	double p = ACOS_A[7];
+	for(int i = 6; i >= 0; i--)
+		p = p*ax + ACOS_A[i];
+
+	double r = sqrt(1.0 - ax) * p;
+	return x < 0.0 ? PI - r : r;
+}
+
+void corner_curvatures(const double* positions, const int* faces, int begin, int end, double* out)
+{
+	switch( simd_level() )
+	{
+#ifdef SIMD_X86
+		case SIMD_AVX512: corner_curvatures_avx512(positions, faces, begin, end, out); break;
+		case SIMD_AVX2: corner_curvatures_avx2(positions, faces, begin, end, out); break;
+#endif
+		default: corner_curvatures_scalar(positions, faces, begin, end, out);
+	}
+}
+
+void classify_convexity(const double* positions, const double* curvatures, const double centroid[3],
+						int begin, int end, Convexity* types)
+{
+	switch( simd_level() )
+	{
+#ifdef SIMD_X86
+		case SIMD_AVX512: classify_convexity_avx512(positions, curvatures, centroid, begin, end, types); break;
+		case SIMD_AVX2: classify_convexity_avx2(positions, curvatures, centroid, begin, end, types); break;
+#endif
+		default: classify_convexity_scalar(positions, curvatures, centroid, begin, end, types);
+	}
+}
+
+void transform_points(const double* positions, const double* normals, int begin, int end,
+					  const double* poses, int k, double* out_positions, double* out_normals)
+{
+	TransformKernel kernel;
+	switch( simd_level() )
+	{
+#ifdef SIMD_X86
+		case SIMD_AVX512: kernel = use_fused(SIMD_AVX512) ? transform_fused_avx512 : transform_avx512; break;
+		case SIMD_AVX2: kernel = use_fused(SIMD_AVX2) ? transform_fused_avx2 : transform_avx2; break;
+#endif
+		default: kernel = transform_scalar;
+	}
+
+	int n = end - begin;
+	for(int b = begin; b < end; b += TRANSFORM_BLOCK)
+	{
+		int e = std::min(b + TRANSFORM_BLOCK, end);
+		for(int j = 0; j < k; j++)
+		{
+			const double* m = poses + 16*j;
+			size_t at = 3*( (size_t)j*n + (b - begin) );
+			if(positions && out_positions) kernel(positions, b, e, m, true, out_positions + at);
+			if(normals && out_normals) kernel(normals, b, e, m, false, out_normals + at);
+		}
+	}
+}
\ No newline at end of file
@@ -2,4 +2,17 @@
 
 int Parameters::PATCH_SIZE_THRESH = 8;
 int Parameters::N_BEST_PAIRS = 5;
-double Parameters::G_THRESH = 2.0;
\ No newline at end of file
+double Parameters::G_THRESH = 2.0;
+int Parameters::N_THREADS = 0;
+double Parameters::CONTACT_DIST = 1.5;
+double Parameters::CLASH_DEPTH = 1.0;
+double Parameters::CLASH_PENALTY = 10.0;
+int Parameters::N_BEST_POSES = 10;
+double Parameters::GRID_SPACING = 0.5;
+int Parameters::ICP_MAX_ITERATIONS = 30;
+double Parameters::ICP_MAX_DIST = 3.0;
+double Parameters::ICP_TOLERANCE = 1e-4;
+double Parameters::FFT_SPACING = 1.0;
+int Parameters::FFT_ROTATIONS = 1000;
+int Parameters::SIMD_LEVEL = 2;
+int Parameters::FUSED_TRANSFORMS = 0;
\ No newline at end of file
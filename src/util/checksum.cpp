@@ -0,0 +1,26 @@
+#include "../../inc/util/checksum.h"
+#include <cstring>
+
+uint64_t checksum(const char* data, size_t n)
+{
+	const uint64_t P1 = 0x9E3779B185EBCA87ULL, P2 = 0xC2B2AE3D27D4EB4FULL;
+	uint64_t h[4] = { P1, P2, ~P1, ~P2 };
+
+	size_t i = 0;
+	for( ; i + 32 <= n; i += 32)
+	{
+		for(int l = 0; l < 4; l++)
+		{
+			uint64_t w; memcpy(&w, data + i + 8*l, 8);
+			h[l] += w * P2;
+			h[l] = (h[l] << 31) | (h[l] >> 33);
+			h[l] *= P1;
+		}
+	}
+
+	uint64_t acc = n * P1;
+	for(int l = 0; l < 4; l++) acc = (acc ^ h[l]) * P2;
+	for( ; i < n; i++) acc = (acc ^ (unsigned char)data[i]) * P1;
+
+	return acc ^ (acc >> 29);
+}
@@ -0,0 +1,44 @@
+#include "../../inc/util/concurrent_unionfind.h"
+
+ConcurrentUnionFind::ConcurrentUnionFind(unsigned int n_elements)
+	: parent(new std::atomic<int>[n_elements]), n(n_elements)
+{
+	for(int i = 0; i < this->n; i++)
+		parent[i].store(i, std::memory_order_relaxed);
+}
+
+int ConcurrentUnionFind::find(int a)
+{
+	while(true)
+	{
+		int p = parent[a].load(std::memory_order_relaxed);
+		if(p == a) return a;
+
+		//try to point A to its grandparent. If someone else changed
+		//parent[a] in the meantime it doesn't matter, we just move on:
+		//parents only ever move up the same tree
+		int gp = parent[p].load(std::memory_order_relaxed);
+		if(gp != p)
+			parent[a].compare_exchange_weak(p, gp, std::memory_order_relaxed);
+
+		a = gp;
+	}
+}
+
+void ConcurrentUnionFind::merge(int a, int b)
+{
+	while(true)
+	{
+		a = find(a);
+		b = find(b);
+		if(a == b) return;
+
+		//link the larger root below the smaller one
+		if(a < b) { int t = a; a = b; b = t; }
+
+		//this only succeeds if A is still a root; otherwise
+		//someone linked it first and we try again from the top
+		int expected = a;
+		if( parent[a].compare_exchange_strong(expected, b) ) return;
+	}
+}
@@ -0,0 +1,78 @@
+#include "../../inc/util/kd_tree.h"
+#include <algorithm>
+
+//------------------------------------------------------
+//--------------------- FROM KD_TREE.H -----------------
+//------------------------------------------------------
+KDTree::KDTree(ConstSpan<glm::dvec3> cloud) : nodes(cloud.size())
+{
+	for(unsigned int i = 0; i < cloud.size(); i++)
+	{
+		nodes[i].pos = cloud[i];
+		nodes[i].id = i;
+		nodes[i].axis = 0;
+	}
+
+	build(0, nodes.size());
+}
+
+//The middle point of [BEGIN, END) splits it along the axis where the
+//points spread the most: lesser coordinates go before it, greater after
+void KDTree::build(int begin, int end)
+{
+	if(end - begin <= 1) return;
+
+	glm::dvec3 lo = nodes[begin].pos, hi = nodes[begin].pos;
+	for(int i = begin + 1; i < end; i++)
+	{
+		lo = glm::min(lo, nodes[i].pos);
+		hi = glm::max(hi, nodes[i].pos);
+	}
+
+	glm::dvec3 spread = hi - lo;
+	int axis = spread.x >= spread.y ? (spread.x >= spread.z ? 0 : 2) : (spread.y >= spread.z ? 1 : 2);
+
+	int mid = begin + (end - begin) / 2;
+	std::nth_element(nodes.begin() + begin, nodes.begin() + mid, nodes.begin() + end,
+					 [axis](const Node& lhs, const Node& rhs) { return lhs.pos[axis] < rhs.pos[axis]; });
+	nodes[mid].axis = axis;
+
+	build(begin, mid);
+	build(mid + 1, end);
+}
+
+void KDTree::search(int begin, int end, const glm::dvec3& p, int& best, double& best_dist2) const
+{
+	if(begin >= end) return;
+
+	int mid = begin + (end - begin) / 2;
+	const Node& node = nodes[mid];
+
+	glm::dvec3 diff = node.pos - p;
+	double dist2 = glm::dot(diff, diff);
+	if(dist2 < best_dist2) { best_dist2 = dist2; best = mid; }
+
+	if(end - begin == 1) return;
+
+	//the side of P first; the other one only if it may hold something closer
+	double d = p[node.axis] - node.pos[node.axis];
+	if(d < 0.0)
+	{
+		search(begin, mid, p, best, best_dist2);
+		if(d*d < best_dist2) search(mid + 1, end, p, best, best_dist2);
+	}
+	else
+	{
+		search(mid + 1, end, p, best, best_dist2);
+		if(d*d < best_dist2) search(begin, mid, p, best, best_dist2);
+	}
+}
+
+int KDTree::nearest(const glm::dvec3& p, double max_dist, double& dist2) const
+{
+	int best = -1;
+	dist2 = max_dist * max_dist;
+	search(0, nodes.size(), p, best, dist2);
+
+	return best < 0 ? -1 : nodes[best].id;
+}
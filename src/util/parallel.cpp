@@ -0,0 +1,53 @@
+#include "../../inc/util/parallel.h"
+#include "../../inc/parameters.h"
+#include <thread>
+#include <vector>
+
+//Set on threads where parallel_for must not spawn anything
+static thread_local bool thread_serial = false;
+
+int worker_count()
+{
+	if(Parameters::N_THREADS > 0) return Parameters::N_THREADS;
+
+	int hw = std::thread::hardware_concurrency();
+	return hw > 0 ? hw : 1;
+}
+
+void parallel_for(int begin, int end, const std::function<void(int, int, int)>& body)
+{
+	int n = end - begin;
+	if(n <= 0) return;
+
+	int n_chunks = worker_count();
+	if(n_chunks > n) n_chunks = n;
+
+	//not worth spawning anything, or not allowed to
+	if(n_chunks == 1 || thread_serial)
+	{
+		body(begin, end, 0);
+		return;
+	}
+
+	//chunk c covers [begin + c*n/n_chunks, begin + (c+1)*n/n_chunks);
+	//the calling thread takes the first one
+	std::vector<std::thread> workers;
+	workers.reserve(n_chunks - 1);
+
+	for(int c = 1; c < n_chunks; c++)
+	{
+		int b = begin + (long long)c * n / n_chunks;
+		int e = begin + (long long)(c + 1) * n / n_chunks;
+		workers.push_back( std::thread(body, b, e, c) );
+	}
+
+	body(begin, begin + n / n_chunks, 0);
+
+	for(auto w = workers.begin(); w != workers.end(); ++w)
+		w->join();
+}
+
+void set_thread_serial(bool serial)
+{
+	thread_serial = serial;
+}
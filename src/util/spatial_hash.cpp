@@ -0,0 +1,40 @@
+#include "../../inc/util/spatial_hash.h"
+#include <cmath>
+
+//------------------------------------------------------
+//--------------------- INTERNAL -----------------------
+//------------------------------------------------------
+//Cell coordinates are packed in 21 bits each. Far away cells may share
+//a key; that only adds candidates to a query, never loses one.
+static const int CELL_BITS = 21;
+static const uint64_t CELL_MASK = (1ULL << CELL_BITS) - 1;
+
+uint64_t SpatialHash::key(int64_t x, int64_t y, int64_t z) const
+{
+	return ((uint64_t)x & CELL_MASK) | (((uint64_t)y & CELL_MASK) << CELL_BITS) | (((uint64_t)z & CELL_MASK) << (2*CELL_BITS));
+}
+
+//-----------------------------------------------------
+//--------------- FROM SPATIAL_HASH.H -----------------
+//-----------------------------------------------------
+SpatialHash::SpatialHash(double cell_size) : cell_size(cell_size) { }
+
+void SpatialHash::insert(const glm::dvec3& p, int id)
+{
+	std::vector<int>& cell = cells[ key(floor(p.x / cell_size), floor(p.y / cell_size), floor(p.z / cell_size)) ];
+	if(cell.empty() || cell.back() != id) cell.push_back(id);
+}
+
+void SpatialHash::near(const glm::dvec3& p, std::vector<int>& out) const
+{
+	int64_t cx = floor(p.x / cell_size), cy = floor(p.y / cell_size), cz = floor(p.z / cell_size);
+
+	for(int64_t x = cx - 1; x <= cx + 1; x++)
+		for(int64_t y = cy - 1; y <= cy + 1; y++)
+			for(int64_t z = cz - 1; z <= cz + 1; z++)
+			{
+				auto cell = cells.find( key(x, y, z) );
+				if(cell != cells.end())
+					out.insert(out.end(), cell->second.begin(), cell->second.end());
+			}
+}
@@ -0,0 +1,117 @@
+#include "../../inc/util/thread_pool.h"
+#include "../../inc/util/parallel.h"
+
+//------------------------------------------
+//--------------- INTERNAL -----------------
+//------------------------------------------
+//Pool and deque of the worker running on this thread, if any
+static thread_local ThreadPool* current_pool = NULL;
+static thread_local int current_queue = -1;
+
+//Takes a task from the back of our own deque or, if it's empty,
+//steals one from the front of the other workers' deques
+bool ThreadPool::take_task(int id, std::function<void()>& task)
+{
+	int n = queues.size();
+	for(int k = 0; k < n; k++)
+	{
+		TaskQueue& q = *queues[ (id + k) % n ];
+		std::lock_guard<std::mutex> guard(q.lock);
+		if(q.tasks.empty()) continue;
+
+		if(k == 0) { task = std::move(q.tasks.back()); q.tasks.pop_back(); }
+		else { task = std::move(q.tasks.front()); q.tasks.pop_front(); }
+
+		queued--;
+		return true;
+	}
+
+	return false;
+}
+
+void ThreadPool::worker_loop(int id)
+{
+	current_pool = this;
+	current_queue = id;
+	set_thread_serial(true);
+
+	std::function<void()> task;
+	while(true)
+	{
+		if( take_task(id, task) )
+		{
+			task();
+			task = nullptr;
+
+			if( --pending == 0 )
+			{
+				std::lock_guard<std::mutex> guard(state_lock);
+				all_done.notify_all();
+			}
+			continue;
+		}
+
+		std::unique_lock<std::mutex> guard(state_lock);
+		has_work.wait(guard, [this] { return stopping || queued > 0; });
+		if(stopping && queued <= 0) return;
+	}
+}
+
+//-----------------------------------------------------
+//--------------- FROM THREAD_POOL.H ------------------
+//-----------------------------------------------------
+ThreadPool::ThreadPool(int n_workers) : queued(0), pending(0), stopping(false), next_queue(0)
+{
+	if(n_workers <= 0) n_workers = worker_count();
+
+	for(int i = 0; i < n_workers; i++)
+		queues.push_back( std::unique_ptr<TaskQueue>(new TaskQueue()) );
+
+	//all deques must exist before any worker starts stealing
+	for(int i = 0; i < n_workers; i++)
+		workers.push_back( std::thread(&ThreadPool::worker_loop, this, i) );
+}
+
+ThreadPool::~ThreadPool()
+{
+	wait();
+
+	{
+		std::lock_guard<std::mutex> guard(state_lock);
+		stopping = true;
+	}
+	has_work.notify_all();
+
+	for(auto w = workers.begin(); w != workers.end(); ++w)
+		w->join();
+}
+
+void ThreadPool::submit(const std::function<void()>& task)
+{
+	pending++;
+
+	int q;
+	if(current_pool == this) q = current_queue;
+	else
+	{
+		std::lock_guard<std::mutex> guard(state_lock);
+		q = next_queue++ % queues.size();
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(queues[q]->lock);
+		queues[q]->tasks.push_back(task);
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(state_lock);
+		queued++;
+	}
+	has_work.notify_one();
+}
+
+void ThreadPool::wait()
+{
+	std::unique_lock<std::mutex> guard(state_lock);
+	all_done.wait(guard, [this] { return pending == 0; });
+}
@@ -1,57 +1,69 @@
 #include "../../inc/util/unionfind.h"
-#include <cstring>
 
-UnionFind::UnionFind(unsigned int n_elements)
+UnionFind::UnionFind(unsigned int n_elements) : parent(n_elements), set_size(n_elements, 1)
 {
-	this->n = n_elements;
-	this->parent = new int[n_elements];
-	for(int i = 0; i < n_elements; i++)
+	for(unsigned int i = 0; i < n_elements; i++)
 		this->parent[i] = i;
 }
 
-UnionFind::~UnionFind()
-{
-	delete[] parent;
-}
-
 int UnionFind::find(int a) const
 {
-	//TODO: error checking here
-	if( parent[a] == a ) return a;
-	else return find(parent[a]);
+	//walk up to the root, making every other node
+	//on the way point to its grandparent
+	while( parent[a] != a )
+	{
+		parent[a] = parent[ parent[a] ];
+		a = parent[a];
+	}
+
+	return a;
 }
 
 void UnionFind::merge(int a, int b)
 {
-	//no path compression or union-by-ranking or whatsoever
 	int pa = find(a), pb = find(b);
+	if(pa == pb) return;
+
+	//hang the smaller tree below the larger one
+	if( set_size[pa] < set_size[pb] ) { int t = pa; pa = pb; pb = t; }
+
 	parent[pb] = pa;
+	set_size[pa] += set_size[pb];
 }
 
-void UnionFind::clusters(std::vector< std::vector<int> >& clusters) const
+void UnionFind::clusters(std::vector<int>& offsets, std::vector<int>& members) const
 {
-	int count = 0;
-	int *hash = new int[this->n];
-	memset(hash, -1, sizeof(int)*this->n);
+	int n = this->size();
+
+	//number the clusters by order of first appearance, i.e., by
+	//their smallest element, and count how many elements each has.
+	//id[] first maps roots to cluster numbers, then elements to them.
+	std::vector<int> id(n, -1);
+	offsets.assign(1, 0);
 
-	for(int i = 0; i < this->n; i++)
+	for(int i = 0; i < n; i++)
 	{
-		//get representative for the subset which
-		//i belongs
 		int s = find(i);
 
-		//if this representative is not yet in the list,
-		//i.e., its hash is -1, assign to it a fresh hash code
-		//and push a new list to the list of lists
-		if( hash[s] == -1 ) 
+		if( id[s] == -1 )
 		{
-			hash[s] = count++;
-			clusters.push_back( std::vector<int>() );
+			id[s] = offsets.size() - 1;
+			offsets.push_back(0);
 		}
 
-		//put i in the correct cluster
-		clusters.at(hash[s]).push_back(i);
+		offsets[ id[s] + 1 ]++;
 	}
 
-	delete[] hash;
+	for(int i = 0; i < n; i++)
+		id[i] = id[ find(i) ];
+
+	//turn counts into offsets and scatter elements in increasing order
+	for(unsigned int k = 1; k < offsets.size(); k++)
+		offsets[k] += offsets[k-1];
+
+	std::vector<int> cursor(offsets.begin(), offsets.end() - 1);
+	members.resize(n);
+
+	for(int i = 0; i < n; i++)
+		members[ cursor[ id[i] ]++ ] = i;
 }
@@ -1,6 +1,7 @@
 #include "../../inc/visualization/render.h"
 #include "../../inc/visualization/shader_loader.h"
 #include "../../inc/math/linalg.h"
+#include "../../inc/graph/transformed_view.h"
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/string_cast.hpp>
@@ -16,26 +17,27 @@ struct _vertex {
 };
 
 //Just to not have to type this behemoth in main pack_geometry_data
-#define NODE2VERTEX(n) ( (Vertex){n.get_pos(), n.get_normal(), n.get_color()} )
+#define NODE2VERTEX(g, pos, nrm, n) ( (Vertex){pos[n], nrm[n], g.get_color(n)} )
 
 //----------------------------------
 //----------- Internal -------------
 //----------------------------------
 static void pack_geometry_data(const Graph& in, std::vector<Vertex>& out)
 {
+	//the mesh is drawn in its current pose: every node is transformed
+	//once, then shared by its faces
+	std::vector<glm::dvec3> pos( in.size() ), nrm( in.size() );
+	TransformedView(in).transform(0, in.size(), pos.data(), nrm.data());
+
 	//pack mesh data into vertex buffer
-	for(int i = 0; i < in.n_faces(); i++)
+	for(unsigned int i = 0; i < in.n_faces(); i++)
 	{
 		const Face& f = in.get_face(i);
 
 		//pack data
-		const Node &f1 = in.get_node(f.a), 
-					&f2 = in.get_node(f.b), 
-					&f3 = in.get_node(f.c);
-
-		out.push_back( NODE2VERTEX(f1) );
-		out.push_back( NODE2VERTEX(f2) );
-		out.push_back( NODE2VERTEX(f3) );
+		out.push_back( NODE2VERTEX(in, pos, nrm, f.a) );
+		out.push_back( NODE2VERTEX(in, pos, nrm, f.b) );
+		out.push_back( NODE2VERTEX(in, pos, nrm, f.c) );
 	}
 }
 
@@ -0,0 +1,54 @@
+#include "test.h"
+#include <vector>
+#include <utility>
+#include <cstring>
+
+//------------------------------------------------------
+//--------------------- INTERNAL -----------------------
+//------------------------------------------------------
+static std::vector< std::pair<const char*, TestFunction> >& registry()
+{
+	static std::vector< std::pair<const char*, TestFunction> > tests;
+	return tests;
+}
+
+//failed checks of the running test
+static int n_failed_checks = 0;
+
+//------------------------------------------------------
+//-------------------- FROM TEST.H ---------------------
+//------------------------------------------------------
+TestRegistrar::TestRegistrar(const char* name, TestFunction f)
+{
+	registry().push_back( std::make_pair(name, f) );
+}
+
+void test_failed(const char* file, int line, const char* what)
+{
+	//don't flood the output when a check fails inside a loop
+	if(n_failed_checks++ < 10)
+		std::cerr<<"  "<<file<<":"<<line<<": CHECK("<<what<<") failed"<<std::endl;
+}
+
+//	run_tests [FILTER]
+//Returns 1 if any test failed
+int main(int argc, char** args)
+{
+	const char* filter = argc > 1 ? args[1] : "";
+	int n_tests = 0, n_failed = 0;
+
+	for(auto t = registry().begin(); t != registry().end(); ++t)
+	{
+		if( !strstr(t->first, filter) ) continue;
+
+		n_failed_checks = 0;
+		t->second();
+		n_tests++;
+
+		if(n_failed_checks > 0) n_failed++;
+		std::cout<<(n_failed_checks > 0 ? "FAIL " : "ok   ")<<t->first<<std::endl;
+	}
+
+	std::cout<<n_tests - n_failed<<"/"<<n_tests<<" tests passed"<<std::endl;
+	return n_failed > 0 ? 1 : 0;
+}
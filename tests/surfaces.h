@@ -0,0 +1,100 @@
+#ifndef _SURFACES_H_
+#define _SURFACES_H_
+
+#include <string>
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+#include "../inc/graph/graph.h"
+
+//Synthetic surfaces for the tests and benchmarks, so they don't depend
+//on data files of the right size.
+
+//UV sphere of radius RADIUS: RINGS rings of SEGMENTS nodes each, plus
+//the two poles (2 + RINGS*SEGMENTS nodes). Normals point outwards.
+//The adjacency is not built. With an AMPLITUDE, the radius is scaled by
+//1 + AMPLITUDE*sin(FREQUENCY*theta)*cos(FREQUENCY*phi), which gives
+//bumps and pits (convex and concave regions); the normals stay radial.
+inline void sphere_surface(int rings, int segments, double radius, Graph& g,
+						   double amplitude = 0.0, int frequency = 0)
+{
+	const double PI = 3.14159265358979323846;
+	int n = 2 + rings * segments;
+
+	g.reserve_nodes(n);
+	g.reserve_faces(2 * rings * segments);
+
+	g.push_node(0.0, 0.0, radius, 0.0, 0.0, 1.0);
+	for(int r = 0; r < rings; r++)
+	{
+		double theta = PI * (r + 1) / (rings + 1);
+		for(int s = 0; s < segments; s++)
+		{
+			double phi = 2.0 * PI * s / segments;
+			double x = sin(theta) * cos(phi), y = sin(theta) * sin(phi), z = cos(theta);
+			double rho = radius * (1.0 + amplitude * sin(frequency * theta) * cos(frequency * phi));
+			g.push_node(rho * x, rho * y, rho * z, x, y, z);
+		}
+	}
+	g.push_node(0.0, 0.0, -radius, 0.0, 0.0, -1.0);
+
+	//node s of ring r
+	auto at = [segments](int r, int s) { return 1 + r * segments + (s % segments); };
+
+	for(int s = 0; s < segments; s++)
+	{
+		g.push_face(0, at(0, s), at(0, s + 1));
+		g.push_face(n - 1, at(rings - 1, s + 1), at(rings - 1, s));
+	}
+
+	for(int r = 0; r + 1 < rings; r++)
+	{
+		for(int s = 0; s < segments; s++)
+		{
+			g.push_face(at(r, s), at(r + 1, s), at(r + 1, s + 1));
+			g.push_face(at(r, s), at(r + 1, s + 1), at(r, s + 1));
+		}
+	}
+}
+
+//Sphere with about N nodes, twice as many segments as rings
+inline void sphere_surface(int n, double radius, Graph& g, double amplitude = 0.0, int frequency = 0)
+{
+	int rings = std::max(1, (int)sqrt(n / 2.0));
+	sphere_surface(rings, 2 * rings, radius, g, amplitude, frequency);
+}
+
+//Writes G as BASENAME.vert/BASENAME.face in the MSMS format (three header
+//lines, then one vertex or 1-based face per line). Returns false if a
+//file could not be written.
+inline bool write_msms(const Graph& g, const std::string& basename)
+{
+	FILE* vert = fopen( (basename + ".vert").c_str(), "w" );
+	if(!vert) return false;
+
+	fprintf(vert, "# MSMS solvent excluded surface vertices\n#vertex #sphere density probe_r\n");
+	fprintf(vert, "%7u %7d %5.2f %5.2f\n", g.size(), 1, 1.0, 1.5);
+	for(unsigned int i = 0; i < g.size(); i++)
+	{
+		const glm::dvec3 &p = g.get_pos(i), &nrm = g.get_normal(i);
+		fprintf(vert, "%9.3f %9.3f %9.3f %7.3f %7.3f %7.3f %7d %7d %2d\n",
+				p.x, p.y, p.z, nrm.x, nrm.y, nrm.z, 0, 1, 2);
+	}
+	fclose(vert);
+
+	FILE* face = fopen( (basename + ".face").c_str(), "w" );
+	if(!face) return false;
+
+	fprintf(face, "# MSMS solvent excluded surface faces\n#faces  #sphere density probe_r\n");
+	fprintf(face, "%7u %7d %5.2f %5.2f\n", g.n_faces(), 1, 1.0, 1.5);
+	for(unsigned int i = 0; i < g.n_faces(); i++)
+	{
+		Face f = g.get_face(i);
+		fprintf(face, "%6d %6d %6d %2d %6d\n", f.a + 1, f.b + 1, f.c + 1, 1, 1);
+	}
+	fclose(face);
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef _TEST_H_
+#define _TEST_H_
+
+#include <iostream>
+#include <cmath>
+
+//Tests register themselves at startup and are all run by "make test"
+//(or only those whose name contains the first argument of run_tests).
+//A failed CHECK prints where it failed and marks the test as failed,
+//but the test goes on, so a run reports every broken case at once.
+typedef void (*TestFunction)();
+
+class TestRegistrar
+{
+public:
+	TestRegistrar(const char* name, TestFunction f);
+};
+
+#define TEST(name) \
+	static void test_##name(); \
+	static TestRegistrar test_registrar_##name(#name, test_##name); \
+	static void test_##name()
+
+//Records a failed check of the running test
+void test_failed(const char* file, int line, const char* what);
+
+#define CHECK(cond) \
+	do { if(!(cond)) test_failed(__FILE__, __LINE__, #cond); } while(0)
+
+//|A - B| <= TOL, printing both values when it fails
+#define CHECK_NEAR(a, b, tol) \
+	do { \
+		double check_a_ = (a), check_b_ = (b); \
+		if( !(fabs(check_a_ - check_b_) <= (tol)) ) { \
+			std::cerr<<"    "<<#a<<" = "<<check_a_<<", "<<#b<<" = "<<check_b_<<std::endl; \
+			test_failed(__FILE__, __LINE__, #a " ~ " #b); \
+		} \
+	} while(0)
+
+#endif
@@ -0,0 +1,86 @@
+#include "test.h"
+#include "surfaces.h"
+#include "../inc/io/fileio.h"
+#include <cstdio>
+
+//------------------------------------------------------
+//--------------------- INTERNAL -----------------------
+//------------------------------------------------------
+//Same nodes, faces, adjacency and curvatures, bitwise
+static void check_same_graph(const Graph& a, const Graph& b)
+{
+	CHECK( a.size() == b.size() );
+	CHECK( a.n_faces() == b.n_faces() );
+	if(a.size() != b.size() || a.n_faces() != b.n_faces()) return;
+
+	for(unsigned int i = 0; i < a.size(); i++)
+	{
+		CHECK( a.get_pos(i) == b.get_pos(i) );
+		CHECK( a.get_normal(i) == b.get_normal(i) );
+		CHECK( a.get_curvature(i) == b.get_curvature(i) );
+		CHECK( a.get_type(i) == b.get_type(i) );
+
+		ConstSpan<int> na = a.neighbours(i), nb = b.neighbours(i);
+		CHECK( std::vector<int>(na.begin(), na.end()) == std::vector<int>(nb.begin(), nb.end()) );
+
+		typedef std::vector< std::pair<int,int> > Pairs;
+		ConstSpan< std::pair<int,int> > fa = a.incident_faces(i), fb = b.incident_faces(i);
+		CHECK( Pairs(fa.begin(), fa.end()) == Pairs(fb.begin(), fb.end()) );
+	}
+
+	for(unsigned int f = 0; f < a.n_faces(); f++)
+	{
+		Face fa = a.get_face(f), fb = b.get_face(f);
+		CHECK( fa.a == fb.a && fa.b == fb.b && fa.c == fb.c );
+	}
+}
+
+//------------------------------------------------------
+//----------------------- TESTS ------------------------
+//------------------------------------------------------
+//A surface loaded back from its cache (viewing the file) is the one
+//that was preprocessed, and it can still be modified
+TEST(cache_round_trip)
+{
+	const std::string base = "test_cache_surface";
+	{
+		Graph g;
+		sphere_surface(30, 60, 10.0, g, 0.2, 3);
+		CHECK( write_msms(g, base) );
+	}
+
+	Graph built, loaded;
+	std::vector< std::pair<Patch, Descriptor> > desc_built, desc_loaded;
+	LoadStats stats;
+
+	CHECK( FileIO().surface_from_file(base, built, desc_built, &stats) );
+	CHECK( !stats.from_cache );
+	CHECK( FileIO().surface_from_file(base, loaded, desc_loaded, &stats) );
+	CHECK( stats.from_cache );
+
+	check_same_graph(built, loaded);
+
+	CHECK( desc_built.size() == desc_loaded.size() );
+	CHECK( !desc_built.empty() );
+	for(unsigned int i = 0; i < desc_built.size() && i < desc_loaded.size(); i++)
+	{
+		CHECK( desc_built[i].first.nodes == desc_loaded[i].first.nodes );
+		CHECK( desc_built[i].second.curv == desc_loaded[i].second.curv );
+		CHECK( desc_built[i].second.type == desc_loaded[i].second.type );
+	}
+
+	const PatchGeodesics &gb = built.get_patch_geodesics(), &gl = loaded.get_patch_geodesics();
+	CHECK( gb.size() == gl.size() );
+	for(int i = 0; i < gb.size() && i < gl.size(); i++)
+		for(int j = 0; j < gb.size(); j++) CHECK( gb.distance(i, j) == gl.distance(i, j) );
+
+	//writing to the viewed arrays copies them first
+	loaded.compute_curvatures();
+	loaded.classify_points();
+	loaded.build_adjacency();
+	check_same_graph(built, loaded);
+
+	remove( (base + ".vert").c_str() );
+	remove( (base + ".face").c_str() );
+	remove( (base + ".spdc").c_str() );
+}
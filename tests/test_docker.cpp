@@ -0,0 +1,252 @@
+#include "test.h"
+#include "surfaces.h"
+#include "../inc/docker/docker.h"
+#include "../inc/parameters.h"
+#include <random>
+#include <cstring>
+#include <algorithm>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/constants.hpp>
+
+//------------------------------------------------------
+//--------------------- INTERNAL -----------------------
+//------------------------------------------------------
+//Appends to G a patch of four nodes around CENTROID, on the plane
+//through it normal to NORMAL, all of them with that normal
+static void push_patch(Graph& g, SurfaceDescriptors& desc, const glm::dvec3& centroid, const glm::dvec3& normal)
+{
+	glm::dvec3 u = glm::normalize( glm::cross(normal, fabs(normal.x) < 0.9 ? glm::dvec3(1.0, 0.0, 0.0) : glm::dvec3(0.0, 1.0, 0.0)) );
+	glm::dvec3 v = glm::cross(normal, u);
+	const glm::dvec3 corners[] = { u, v, -u, -v };
+
+	std::vector<int> nodes;
+	for(int i = 0; i < 4; i++)
+	{
+		glm::dvec3 p = centroid + corners[i];
+		nodes.push_back( g.size() );
+		g.push_node(p.x, p.y, p.z, normal.x, normal.y, normal.z);
+	}
+
+	Descriptor d = { 0.0, CONVEX };
+	desc.push_back( std::make_pair(Patch(normal, nodes), d) );
+}
+
+//Aligns ligand patches (CENTROIDS, NORMALS) onto copies of them moved by
+//R and T, with their normals flipped to face them, as a single matching
+//group. The transformation found must be rigid and bring every patch
+//onto its copy; it is returned.
+static glm::dmat4 align_moved(const std::vector<glm::dvec3>& centroids, const std::vector<glm::dvec3>& normals,
+							  const glm::dmat3& R, const glm::dvec3& t)
+{
+	Graph target, ligand;
+	SurfaceDescriptors desc_target, desc_ligand;
+	MatchingGroup group;
+	for(unsigned int i = 0; i < centroids.size(); i++)
+	{
+		push_patch(ligand, desc_ligand, centroids[i], normals[i]);
+		push_patch(target, desc_target, R * centroids[i] + t, -(R * normals[i]));
+		group.push_back( std::make_pair(i, i) );
+	}
+
+	std::vector<glm::dmat4> transforms;
+	Docker().transformations_from_matching_groups(std::vector<MatchingGroup>(1, group), target, desc_target,
+												  ligand, desc_ligand, transforms);
+	CHECK( transforms.size() == 1 );
+	const glm::dmat4& T = transforms[0];
+
+	const glm::dmat3 rotation = glm::dmat3( glm::dvec3(T[0]), glm::dvec3(T[1]), glm::dvec3(T[2]) );
+	glm::dmat3 rtr = glm::transpose(rotation) * rotation;
+	for(int i = 0; i < 3; i++)
+		for(int j = 0; j < 3; j++) CHECK_NEAR(rtr[i][j], i == j ? 1.0 : 0.0, 1e-12);
+	CHECK_NEAR(glm::determinant(rotation), 1.0, 1e-12);
+	for(int i = 0; i < 3; i++) CHECK_NEAR(T[i][3], 0.0, 0.0);
+	CHECK_NEAR(T[3][3], 1.0, 0.0);
+
+	for(unsigned int i = 0; i < centroids.size(); i++)
+	{
+		glm::dvec3 c = glm::dvec3( T * glm::dvec4(centroids[i], 1.0) ), n = rotation * normals[i];
+		glm::dvec3 expected_c = R * centroids[i] + t, expected_n = R * normals[i];
+		for(int j = 0; j < 3; j++)
+		{
+			CHECK_NEAR(c[j], expected_c[j], 1e-9);
+			CHECK_NEAR(n[j], expected_n[j], 1e-9);
+		}
+	}
+	return T;
+}
+
+//T is the rotation R followed by the translation by t
+static void check_transform(const glm::dmat4& T, const glm::dmat3& R, const glm::dvec3& t)
+{
+	for(int i = 0; i < 3; i++)
+	{
+		for(int j = 0; j < 3; j++) CHECK_NEAR(T[i][j], R[i][j], 1e-9);
+		CHECK_NEAR(T[3][i], t[i], 1e-9);
+	}
+}
+
+static glm::dvec3 random_direction(std::mt19937& rng)
+{
+	std::normal_distribution<double> normal;
+	return glm::normalize( glm::dvec3(normal(rng), normal(rng), normal(rng)) );
+}
+
+static glm::dmat3 random_rotation(std::mt19937& rng)
+{
+	std::uniform_real_distribution<double> angle(0.0, glm::pi<double>());
+	return glm::mat3_cast( glm::angleAxis(angle(rng), random_direction(rng)) );
+}
+
+//N descriptors of random convexity. Curvatures are mostly on a coarse
+//grid, so that many distances tie; if DEGENERATE, a few are 0, negative
+//or NaN, as with degenerate patches.
+static void random_descriptors(int n, bool degenerate, std::mt19937& rng, SurfaceDescriptors& desc)
+{
+	std::uniform_int_distribution<int> type(0, 2), step(1, 40), pick(0, 9);
+	std::uniform_real_distribution<double> value(0.01, 2.0);
+	const double odd[] = { 0.0, -0.1, std::nan("") };
+
+	for(int i = 0; i < n; i++)
+	{
+		int p = pick(rng);
+		Descriptor d = { p < 6 ? 0.05 * step(rng) : value(rng), (Convexity)type(rng) };
+		if(degenerate && p == 9) d.curv = odd[ step(rng) % 3 ];
+
+		desc.push_back( std::make_pair(Patch(glm::dvec3(0.0, 0.0, 1.0), std::vector<int>(1, i)), d) );
+	}
+}
+
+//------------------------------------------------------
+//----------------------- TESTS ------------------------
+//------------------------------------------------------
+//Geodesics computed for a smaller G_THRESH than the one grouping uses
+//can't tell which pairs are close: grouping must fail, not come up empty
+TEST(matching_groups_geodesic_cutoff)
+{
+	Graph g; SurfaceDescriptors desc;
+	sphere_surface(30, 60, 10.0, g, 0.2, 3);
+	g.preprocess_mesh(desc);
+	CHECK( !desc.empty() );
+
+	std::vector<MatchingGroup> groups;
+	CHECK( Docker().build_matching_groups(g, desc, g, desc, groups) );
+	CHECK( !groups.empty() );
+
+	double saved = Parameters::G_THRESH;
+	Parameters::G_THRESH = saved + 1.0;
+
+	groups.clear();
+	CHECK( !Docker().build_matching_groups(g, desc, g, desc, groups) );
+	CHECK( groups.empty() );
+
+	Parameters::G_THRESH = saved;
+}
+
+//Groups of patches spread around, moved by random rigid transformations
+TEST(align_group_random)
+{
+	std::mt19937 rng(31);
+	std::uniform_real_distribution<double> value(-10.0, 10.0);
+
+	for(int t = 0; t < 200; t++)
+	{
+		std::vector<glm::dvec3> centroids, normals;
+		for(int i = 0; i < 5; i++)
+		{
+			centroids.push_back( glm::dvec3(value(rng), value(rng), value(rng)) );
+			normals.push_back( random_direction(rng) );
+		}
+
+		glm::dmat3 R = random_rotation(rng);
+		glm::dvec3 shift(value(rng), value(rng), value(rng));
+		check_transform(align_moved(centroids, normals, R, shift), R, shift);
+	}
+}
+
+//0 and 180 degrees, coplanar patches with parallel normals (a flat
+//sheet), anti-parallel normals (both sides of a slab) and single pairs
+TEST(align_group_degenerate)
+{
+	std::mt19937 rng(37);
+	std::uniform_real_distribution<double> value(-10.0, 10.0);
+	const double pi = glm::pi<double>();
+
+	std::vector<glm::dvec3> centroids, normals, sheet, up, slab, sides;
+	for(int i = 0; i < 5; i++)
+	{
+		centroids.push_back( glm::dvec3(value(rng), value(rng), value(rng)) );
+		normals.push_back( random_direction(rng) );
+
+		sheet.push_back( glm::dvec3(value(rng), value(rng), 0.0) );
+		up.push_back( glm::dvec3(0.0, 0.0, 1.0) );
+
+		slab.push_back( glm::dvec3(value(rng), value(rng), i % 2 ? 2.0 : -2.0) );
+		sides.push_back( glm::dvec3(0.0, 0.0, i % 2 ? 1.0 : -1.0) );
+	}
+
+	const glm::dvec3 shift(1.0, -2.0, 3.0);
+	std::vector<glm::dmat3> rotations(1, glm::dmat3(1.0));
+	const glm::dvec3 axes[] = { glm::dvec3(1.0, 0.0, 0.0), glm::dvec3(0.0, 1.0, 0.0), glm::dvec3(0.0, 0.0, 1.0) };
+	for(int i = 0; i < 3; i++) rotations.push_back( glm::mat3_cast( glm::angleAxis(pi, axes[i]) ) );
+	for(int i = 0; i < 10; i++)
+	{
+		rotations.push_back( glm::mat3_cast( glm::angleAxis(pi, random_direction(rng)) ) );
+		rotations.push_back( random_rotation(rng) );
+	}
+
+	for(auto R = rotations.begin(); R != rotations.end(); ++R)
+	{
+		check_transform(align_moved(centroids, normals, *R, glm::dvec3(0.0)), *R, glm::dvec3(0.0));
+		check_transform(align_moved(centroids, normals, *R, shift), *R, shift);
+		check_transform(align_moved(sheet, up, *R, shift), *R, shift);
+		check_transform(align_moved(slab, sides, *R, shift), *R, shift);
+
+		//a single pair leaves the spin about its normal free
+		align_moved(std::vector<glm::dvec3>(1, centroids[0]), std::vector<glm::dvec3>(1, normals[0]), *R, shift);
+		align_moved(std::vector<glm::dvec3>(1, sheet[0]), std::vector<glm::dvec3>(1, up[0]), *R, shift);
+	}
+}
+
+//An index over the ligand patches selects, for every target patch, the
+//K ligand patches a full sort puts first, in the same order (ties broken
+//by index, NaN distances last)
+TEST(descriptor_index_full_sort)
+{
+	std::mt19937 rng(15);
+	const int KS[] = { 1, 3, 10, 50 };
+	CandidateOrder order;
+
+	for(int trial = 0; trial < 3; trial++)
+	{
+		SurfaceDescriptors target, ligand;
+		random_descriptors(300, trial == 1, rng, target);
+		random_descriptors(200, trial == 2, rng, ligand);
+		DescriptorIndex index(ligand);
+
+		CandidateSelection best;
+		std::vector<Candidate> expected, selected;
+		for(int k : KS)
+		{
+			for(unsigned int t = 0; t < target.size(); t++)
+			{
+				const Descriptor& d = target[t].second;
+				expected.clear();
+				for(unsigned int l = 0; l < ligand.size(); l++)
+					if(ligand[l].second.type != d.type)
+						expected.push_back( std::make_pair(curvature_distance(d.curv, ligand[l].second.curv), l) );
+
+				std::sort(expected.begin(), expected.end(), order);
+				if( (int)expected.size() > k ) expected.resize(k);
+
+				index.most_complementary(d, k, best);
+				best.sorted(selected);
+				CHECK( selected.size() == expected.size() );
+				for(unsigned int i = 0; i < selected.size() && i < expected.size(); i++)
+				{
+					CHECK( selected[i].second == expected[i].second );
+					CHECK( memcmp(&selected[i].first, &expected[i].first, sizeof(double)) == 0 );
+				}
+			}
+		}
+	}
+}
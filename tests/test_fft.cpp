@@ -0,0 +1,168 @@
+#include "test.h"
+#include "surfaces.h"
+#include "../inc/math/fft.h"
+#include "../inc/docker/fft_docker.h"
+#include "../inc/parameters.h"
+#include <random>
+#include <algorithm>
+#include <glm/gtc/constants.hpp>
+
+//------------------------------------------------------
+//--------------------- INTERNAL -----------------------
+//------------------------------------------------------
+typedef std::complex<double> Complex;
+
+//Sizes with every radix the plans use: 30 = 2*3*5, 48 = 4*4*3, 60 = 4*3*5
+static const int SIZES[] = { 30, 48, 60 };
+
+static void random_grid(int n, bool real, std::mt19937& rng, std::vector<Complex>& grid)
+{
+	std::uniform_real_distribution<double> value(-1.0, 1.0);
+
+	grid.resize((size_t)n*n*n);
+	for(auto g = grid.begin(); g != grid.end(); ++g)
+	{
+		double re = value(rng);
+		*g = Complex(re, real ? 0.0 : value(rng));
+	}
+}
+
+//Node K of the DFT of GRID, summed directly: SIGN is -1 for the forward
+//transform and +1 for the (unscaled) inverse one
+static Complex naive_dft(const std::vector<Complex>& grid, int n, int kx, int ky, int kz, int sign)
+{
+	const double w = sign * 2.0 * glm::pi<double>() / n;
+	Complex sum(0.0);
+
+	for(int z = 0; z < n; z++)
+	for(int y = 0; y < n; y++)
+	for(int x = 0; x < n; x++)
+	{
+		double angle = w * ((kx*x + ky*y + kz*z) % n);
+		sum += grid[x + n*(y + (size_t)n*z)] * Complex(cos(angle), sin(angle));
+	}
+	return sum;
+}
+
+//Checks forward (or inverse) transforms of random grids against the
+//direct sums, at a few random nodes of each and at the corners
+static void check_against_naive(bool inverse)
+{
+	std::mt19937 rng(inverse ? 7 : 6);
+
+	for(int n : SIZES)
+	{
+		FFTPlan plan(n);
+		std::vector<Complex> grid, transformed;
+		random_grid(n, false, rng, grid);
+
+		transformed = grid;
+		if(inverse) plan.inverse(transformed.data());
+		else plan.forward(transformed.data());
+
+		const double scale = inverse ? 1.0 / ((double)n*n*n) : 1.0;
+		std::uniform_int_distribution<int> node(0, n - 1);
+
+		for(int t = 0; t < 24; t++)
+		{
+			int kx = t < 8 ? (t & 1) * (n - 1) : node(rng);
+			int ky = t < 8 ? ((t >> 1) & 1) * (n - 1) : node(rng);
+			int kz = t < 8 ? ((t >> 2) & 1) * (n - 1) : node(rng);
+
+			Complex expected = scale * naive_dft(grid, n, kx, ky, kz, inverse ? 1 : -1);
+			Complex actual = transformed[kx + n*(ky + (size_t)n*kz)];
+
+			//the n³ terms are at most 1 (or 1/n³) each
+			double tol = 1e-12 * n*n*n * scale;
+			CHECK_NEAR(actual.real(), expected.real(), tol);
+			CHECK_NEAR(actual.imag(), expected.imag(), tol);
+		}
+	}
+}
+
+//------------------------------------------------------
+//----------------------- TESTS ------------------------
+//------------------------------------------------------
+TEST(fft_forward_naive)
+{
+	check_against_naive(false);
+}
+
+TEST(fft_inverse_naive)
+{
+	check_against_naive(true);
+}
+
+TEST(fft_round_trip)
+{
+	std::mt19937 rng(8);
+
+	for(int n : SIZES)
+	{
+		FFTPlan plan(n);
+		std::vector<Complex> grid, work;
+		random_grid(n, false, rng, grid);
+
+		work = grid;
+		plan.forward(work.data());
+		plan.inverse(work.data());
+
+		double error = 0.0;
+		for(size_t i = 0; i < grid.size(); i++) error = std::max(error, std::abs(work[i] - grid[i]));
+		CHECK_NEAR(error, 0.0, 1e-12);
+	}
+}
+
+//Two rotations packed into one complex grid (real and imaginary parts)
+//must give the same correlations as each rotation on its own
+TEST(fft_packed_rotations)
+{
+	Graph ligand;
+	sphere_surface(20, 40, 4.0, ligand, 0.2, 3);
+
+	const double saved = Parameters::FFT_SPACING;
+	Parameters::FFT_SPACING = 1.0;
+
+	ReceptorGrid ligand_grid;
+	ligand_grid.build(ligand, 0.5, 2.0);
+
+	const int n = 30, reach = 6;
+	FFTPlan plan(n);
+
+	std::mt19937 rng(9);
+	std::vector<Complex> rec;
+	random_grid(n, true, rng, rec);
+	plan.forward(rec.data());
+
+	std::vector<glm::dmat3> rotations;
+	FFTDocker::rotation_set(8, rotations);
+	const glm::dvec3 center(0.0);
+
+	std::vector<Complex> packed, first, second;
+	for(unsigned int r = 0; r + 1 < rotations.size(); r += 2)
+	{
+		FFTDocker::correlate(plan, rec, ligand_grid, center, reach, &rotations[r], 2, packed);
+		FFTDocker::correlate(plan, rec, ligand_grid, center, reach, &rotations[r], 1, first);
+		FFTDocker::correlate(plan, rec, ligand_grid, center, reach, &rotations[r + 1], 1, second);
+
+		double largest = 0.0, differ = 0.0;
+		for(size_t i = 0; i < packed.size(); i++)
+		{
+			CHECK_NEAR(packed[i].real(), first[i].real(), 1e-9);
+			CHECK_NEAR(-packed[i].imag(), second[i].real(), 1e-9);
+
+			//single real grids correlate to real grids
+			CHECK_NEAR(first[i].imag(), 0.0, 1e-9);
+			CHECK_NEAR(second[i].imag(), 0.0, 1e-9);
+
+			largest = std::max(largest, fabs(first[i].real()));
+			differ = std::max(differ, fabs(first[i].real() - second[i].real()));
+		}
+
+		//the ligand is there, and the rotations see it differently
+		CHECK( largest > 1.0 );
+		CHECK( differ > 1.0 );
+	}
+
+	Parameters::FFT_SPACING = saved;
+}
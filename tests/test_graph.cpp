@@ -0,0 +1,178 @@
+#include "test.h"
+#include "surfaces.h"
+#include "../inc/io/fileio.h"
+#include <vector>
+#include <set>
+#include <queue>
+#include <string>
+
+//------------------------------------------------------
+//--------------------- INTERNAL -----------------------
+//------------------------------------------------------
+//Curvature, convexity and segmentation, as preprocess_mesh() runs them
+static void segment(Graph& g, UnionFind& uf)
+{
+	if(!g.has_adjacency()) g.build_adjacency();
+	g.compute_curvatures();
+	g.classify_points();
+	g.segment_by_curvature(uf);
+}
+
+//The per-point search distance_to_contour() replaced: a BFS from each
+//point of a region, over all neighbours, which stops at the first point
+//of the region's contour. Returns -1 if the contour can't be reached.
+static int reference_distance(const Graph& g, const std::set<int>& contour, int node)
+{
+	std::vector<char> visited(g.size(), 0);
+	std::queue< std::pair<int,int> > Q;
+	Q.push( std::make_pair(node, 0) );
+	visited[node] = 1;
+
+	while(!Q.empty())
+	{
+		std::pair<int,int> cur = Q.front(); Q.pop();
+		if( contour.count(cur.first) ) return cur.second;
+
+		ConstSpan<int> adj = g.neighbours(cur.first);
+		for(auto n = adj.begin(); n != adj.end(); ++n)
+		{
+			if(visited[*n]) continue;
+			visited[*n] = 1;
+			Q.push( std::make_pair(*n, cur.second + 1) );
+		}
+	}
+
+	return -1;
+}
+
+//Compares the contour distances of every node of G against the reference.
+//Returns the number of nodes on the contour, to make sure the surface
+//had something to check.
+static int check_contour_distances(Graph& g)
+{
+	UnionFind uf( g.size() );
+	segment(g, uf);
+
+	std::vector<int> dist;
+	g.contour_distances(uf, dist);
+	CHECK(dist.size() == g.size());
+
+	std::vector<int> offsets, members;
+	uf.clusters(offsets, members);
+
+	int n_contour = 0;
+	for(unsigned int r = 0; r + 1 < offsets.size(); r++)
+	{
+		std::set<int> contour;
+		for(int i = offsets[r]; i < offsets[r+1]; i++)
+		{
+			int p = members[i];
+			ConstSpan<int> adj = g.neighbours(p);
+			for(auto n = adj.begin(); n != adj.end(); ++n)
+				if(g.get_type(*n) != g.get_type(p)) contour.insert(p);
+		}
+		n_contour += contour.size();
+
+		for(int i = offsets[r]; i < offsets[r+1]; i++)
+			CHECK( dist[ members[i] ] == reference_distance(g, contour, members[i]) );
+	}
+
+	return n_contour;
+}
+
+//Checks that the clusters of UF are exactly the connected components of
+//points of the same convexity, found with a BFS. Returns their number.
+static int check_segments(const Graph& g, const UnionFind& uf)
+{
+	std::vector<int> offsets, members;
+	uf.clusters(offsets, members);
+	int n_clusters = offsets.size() - 1;
+
+	std::vector<int> cluster( g.size() );
+	for(int r = 0; r < n_clusters; r++)
+		for(int i = offsets[r]; i < offsets[r+1]; i++)
+			cluster[ members[i] ] = r;
+
+	std::vector<int> component( g.size(), -1 ), queue;
+	int n_components = 0;
+	for(unsigned int s = 0; s < g.size(); s++)
+	{
+		if(component[s] >= 0) continue;
+
+		//every component must be a single cluster, and no other one
+		int c = n_components++, size = 0;
+		queue.assign(1, s); component[s] = c;
+		for(unsigned int head = 0; head < queue.size(); head++)
+		{
+			int u = queue[head];
+			ConstSpan<int> adj = g.neighbours(u);
+			for(auto n = adj.begin(); n != adj.end(); ++n)
+			{
+				if(component[*n] >= 0 || g.get_type(*n) != g.get_type(u)) continue;
+				component[*n] = c;
+				queue.push_back(*n);
+			}
+			size++;
+		}
+
+		int r = cluster[s];
+		CHECK( offsets[r+1] - offsets[r] == size );
+		for(auto u = queue.begin(); u != queue.end(); ++u) CHECK( cluster[*u] == r );
+	}
+
+	CHECK( n_components == n_clusters );
+	return n_clusters;
+}
+
+//------------------------------------------------------
+//----------------------- TESTS ------------------------
+//------------------------------------------------------
+TEST(contour_distances_data)
+{
+	const char* surfaces[] = { "data/dummy", "data/convexitytest" };
+
+	for(int s = 0; s < 2; s++)
+	{
+		std::string base(surfaces[s]);
+
+		Graph g;
+		CHECK( FileIO().mesh_from_file(base + ".vert", base + ".face", g) );
+		check_contour_distances(g);
+	}
+}
+
+TEST(contour_distances_bumpy_sphere)
+{
+	Graph g;
+	sphere_surface(40, 80, 10.0, g, 0.2, 5);
+	CHECK( check_contour_distances(g) > 0 );
+}
+
+//A sphere is all convex: no contour, so no point can reach it
+TEST(contour_distances_sphere)
+{
+	Graph g;
+	sphere_surface(10, 20, 10.0, g);
+	CHECK( check_contour_distances(g) == 0 );
+}
+
+//Segmentation used to recurse once per point of a region, which
+//overflowed the stack on large surfaces: a 2M-point sphere is a single
+//convex region, and a bumpy one has many regions to tell apart
+TEST(segment_by_curvature_2M)
+{
+	Graph sphere;
+	sphere_surface(2000000, 50.0, sphere);
+	CHECK( sphere.size() >= 2000000 );
+
+	UnionFind uf_sphere( sphere.size() );
+	segment(sphere, uf_sphere);
+	CHECK( check_segments(sphere, uf_sphere) == 1 );
+
+	Graph bumpy;
+	sphere_surface(2000000, 50.0, bumpy, 0.1, 12);
+
+	UnionFind uf_bumpy( bumpy.size() );
+	segment(bumpy, uf_bumpy);
+	CHECK( check_segments(bumpy, uf_bumpy) > 1 );
+}
@@ -0,0 +1,266 @@
+#include "test.h"
+#include "../inc/math/linalg.h"
+#include <random>
+#include <algorithm>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/constants.hpp>
+
+#ifdef HAVE_GSL
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_eigen.h>
+#endif
+
+//------------------------------------------------------
+//--------------------- INTERNAL -----------------------
+//------------------------------------------------------
+//Random rotation, from a uniformly distributed unit quaternion
+static glm::dmat3 random_rotation(std::mt19937& rng)
+{
+	std::normal_distribution<double> normal;
+	double w = normal(rng), x = normal(rng), y = normal(rng), z = normal(rng);
+	double n = sqrt(w*w + x*x + y*y + z*z);
+	w /= n; x /= n; y /= n; z /= n;
+
+	return glm::dmat3( glm::dvec3(1 - 2*(y*y + z*z),     2*(x*y + w*z),     2*(x*z - w*y)),
+					   glm::dvec3(    2*(x*y - w*z), 1 - 2*(x*x + z*z),     2*(y*z + w*x)),
+					   glm::dvec3(    2*(x*z + w*y),     2*(y*z - w*x), 1 - 2*(x*x + y*y)) );
+}
+
+//A = R diag(D) R^T, whose eigenvalues are D and eigenvectors the columns of R
+static void rotated_diagonal(const glm::dmat3& R, const double d[3], double a[3][3])
+{
+	for(int i = 0; i < 3; i++)
+		for(int j = 0; j < 3; j++)
+		{
+			a[i][j] = 0.0;
+			for(int k = 0; k < 3; k++) a[i][j] += R[k][i] * d[k] * R[k][j];
+		}
+}
+
+//Checks the decomposition of A by symmetric_eigen<3>: A v = lambda v for
+//every pair, orthonormal eigenvectors, and (sorted) eigenvalues EXPECTED
+static void check_eigen(const double a[3][3], const double expected[3])
+{
+	double work[3][3], eval[3], evec[3][3];
+	std::copy(&a[0][0], &a[0][0] + 9, &work[0][0]);
+	symmetric_eigen<3>(work, eval, evec);
+
+	double scale = 0.0;
+	for(int i = 0; i < 3; i++) scale = std::max(scale, fabs(expected[i]));
+	double tol = 1e-12 * std::max(scale, 1.0);
+
+	for(int k = 0; k < 3; k++)
+	{
+		for(int i = 0; i < 3; i++)
+		{
+			double av = 0.0;
+			for(int j = 0; j < 3; j++) av += a[i][j] * evec[j][k];
+			CHECK_NEAR(av, eval[k] * evec[i][k], tol);
+		}
+
+		for(int l = 0; l < 3; l++)
+		{
+			double dot = 0.0;
+			for(int i = 0; i < 3; i++) dot += evec[i][k] * evec[i][l];
+			CHECK_NEAR(dot, k == l ? 1.0 : 0.0, 1e-12);
+		}
+	}
+
+	std::sort(eval, eval + 3);
+	for(int i = 0; i < 3; i++) CHECK_NEAR(eval[i], expected[i], tol);
+}
+
+//R^T R = I and det(R) = +1: a rotation, not a reflection, not scaled
+static void check_rotation(const glm::dmat3& R)
+{
+	glm::dmat3 rtr = glm::transpose(R) * R;
+	for(int i = 0; i < 3; i++)
+		for(int j = 0; j < 3; j++) CHECK_NEAR(rtr[i][j], i == j ? 1.0 : 0.0, 1e-12);
+	CHECK_NEAR(glm::determinant(R), 1.0, 1e-12);
+}
+
+//optimal_rotation() of the pairs (A_i, B_i), checked to be a rotation
+static glm::dmat3 fit_rotation(const std::vector<glm::dvec3>& a, const std::vector<glm::dvec3>& b)
+{
+	double m[3][3] = {{0.0}};
+	for(size_t i = 0; i < a.size(); i++)
+		for(int j = 0; j < 3; j++)
+			for(int k = 0; k < 3; k++) m[j][k] += a[i][j] * b[i][k];
+
+	glm::dmat3 R = optimal_rotation(m);
+	check_rotation(R);
+	return R;
+}
+
+//Rotates random vectors by EXPECTED (flattened to the plane z = 0 if
+//COPLANAR) and checks that they give EXPECTED back
+static void check_recovery(const glm::dmat3& expected, bool coplanar, std::mt19937& rng)
+{
+	std::uniform_real_distribution<double> value(-10.0, 10.0);
+	std::vector<glm::dvec3> a, b;
+	for(int i = 0; i < 8; i++)
+	{
+		a.push_back( glm::dvec3(value(rng), value(rng), coplanar ? 0.0 : value(rng)) );
+		b.push_back( expected * a.back() );
+	}
+
+	glm::dmat3 R = fit_rotation(a, b);
+	for(int i = 0; i < 3; i++)
+		for(int j = 0; j < 3; j++) CHECK_NEAR(R[i][j], expected[i][j], 1e-9);
+}
+
+//------------------------------------------------------
+//----------------------- TESTS ------------------------
+//------------------------------------------------------
+TEST(symmetric_eigen_random)
+{
+	std::mt19937 rng(12);
+	std::uniform_real_distribution<double> value(-100.0, 100.0);
+
+	for(int t = 0; t < 1000; t++)
+	{
+		double d[3] = { value(rng), value(rng), value(rng) }, a[3][3];
+		rotated_diagonal(random_rotation(rng), d, a);
+
+		std::sort(d, d + 3);
+		check_eigen(a, d);
+	}
+}
+
+//Repeated eigenvalues, rank-deficient scatters (collinear and coplanar
+//patches), diagonal and zero matrices
+TEST(symmetric_eigen_degenerate)
+{
+	std::mt19937 rng(3);
+	const double cases[][3] = {
+		{ 0.0, 0.0, 0.0 }, { 1.0, 1.0, 1.0 }, { 2.0, 2.0, 5.0 }, { -1.0, 4.0, 4.0 },
+		{ 0.0, 0.0, 7.0 }, { 0.0, 3.0, 9.0 }, { 1e-9, 1.0, 1e9 }
+	};
+
+	for(unsigned int c = 0; c < sizeof(cases) / sizeof(cases[0]); c++)
+	{
+		double a[3][3];
+		rotated_diagonal(glm::dmat3(1.0), cases[c], a);
+		check_eigen(a, cases[c]);
+
+		for(int t = 0; t < 50; t++)
+		{
+			rotated_diagonal(random_rotation(rng), cases[c], a);
+			check_eigen(a, cases[c]);
+		}
+	}
+}
+
+TEST(optimal_rotation_random)
+{
+	std::mt19937 rng(23);
+	for(int t = 0; t < 1000; t++) check_recovery(random_rotation(rng), false, rng);
+}
+
+//0 and 180 degrees (where the quaternion has no scalar part), coplanar
+//and collinear vectors, point reflections and no correlation at all
+TEST(optimal_rotation_degenerate)
+{
+	std::mt19937 rng(29);
+	std::normal_distribution<double> normal;
+	const double pi = glm::pi<double>();
+
+	check_recovery(glm::dmat3(1.0), false, rng);
+	check_recovery(glm::dmat3(1.0), true, rng);
+
+	const glm::dvec3 axes[] = { glm::dvec3(1.0, 0.0, 0.0), glm::dvec3(0.0, 1.0, 0.0), glm::dvec3(0.0, 0.0, 1.0) };
+	for(int i = 0; i < 3; i++) check_recovery(glm::mat3_cast( glm::angleAxis(pi, axes[i]) ), false, rng);
+
+	for(int t = 0; t < 100; t++)
+	{
+		glm::dvec3 axis = glm::normalize( glm::dvec3(normal(rng), normal(rng), normal(rng)) );
+		check_recovery(glm::mat3_cast( glm::angleAxis(pi, axis) ), false, rng);
+		check_recovery(random_rotation(rng), true, rng);
+	}
+
+	//vectors along one line only fix that line
+	for(int t = 0; t < 100; t++)
+	{
+		glm::dmat3 expected = random_rotation(rng);
+		glm::dvec3 line(normal(rng), normal(rng), normal(rng));
+		std::vector<glm::dvec3> a, b;
+		for(int i = -2; i <= 2; i++)
+		{
+			a.push_back( (double)i * line );
+			b.push_back( expected * a.back() );
+		}
+
+		glm::dmat3 R = fit_rotation(a, b);
+		for(int i = 0; i < 3; i++) CHECK_NEAR((R * line)[i], (expected * line)[i], 1e-9);
+	}
+
+	//no rotation maps a cloud onto its point reflection, nor is any
+	//better than another without correlation: still rotations
+	for(int t = 0; t < 100; t++)
+	{
+		std::vector<glm::dvec3> a, b;
+		for(int i = 0; i < 8; i++)
+		{
+			a.push_back( glm::dvec3(normal(rng), normal(rng), normal(rng)) );
+			b.push_back( -a.back() );
+		}
+		fit_rotation(a, b);
+	}
+
+	const double zero[3][3] = {{0.0}};
+	check_rotation( optimal_rotation(zero) );
+}
+
+#ifdef HAVE_GSL
+//Against gsl_eigen_symmv(), which PCA of the patches used before. Both
+//must give the same eigenvalues, and the same eigenvectors up to sign
+//where the eigenvalues are distinct.
+TEST(symmetric_eigen_gsl)
+{
+	std::mt19937 rng(5);
+	std::uniform_real_distribution<double> value(-10.0, 10.0);
+
+	gsl_eigen_symmv_workspace* workspace = gsl_eigen_symmv_alloc(3);
+	gsl_matrix *m = gsl_matrix_alloc(3, 3), *gsl_evec = gsl_matrix_alloc(3, 3);
+	gsl_vector* gsl_eval = gsl_vector_alloc(3);
+
+	for(int t = 0; t < 1000; t++)
+	{
+		//scatter matrix of a random cloud
+		double a[3][3] = {{0.0}};
+		for(int p = 0; p < 20; p++)
+		{
+			double x[3] = { value(rng), value(rng), 0.1 * value(rng) };
+			for(int i = 0; i < 3; i++)
+				for(int j = 0; j < 3; j++) a[i][j] += x[i] * x[j];
+		}
+
+		for(int i = 0; i < 3; i++)
+			for(int j = 0; j < 3; j++) gsl_matrix_set(m, i, j, a[i][j]);
+		gsl_eigen_symmv(m, gsl_eval, gsl_evec, workspace);
+		gsl_eigen_symmv_sort(gsl_eval, gsl_evec, GSL_EIGEN_SORT_VAL_ASC);
+
+		double work[3][3], eval[3], evec[3][3];
+		std::copy(&a[0][0], &a[0][0] + 9, &work[0][0]);
+		symmetric_eigen<3>(work, eval, evec);
+
+		//sort ours the same way
+		int order[3] = { 0, 1, 2 };
+		std::sort(order, order + 3, [&eval](int i, int j) { return eval[i] < eval[j]; });
+
+		double tol = 1e-10 * fabs(gsl_vector_get(gsl_eval, 2));
+		for(int k = 0; k < 3; k++)
+		{
+			CHECK_NEAR(eval[ order[k] ], gsl_vector_get(gsl_eval, k), tol);
+
+			double dot = 0.0;
+			for(int i = 0; i < 3; i++) dot += evec[i][ order[k] ] * gsl_matrix_get(gsl_evec, i, k);
+			CHECK_NEAR(fabs(dot), 1.0, 1e-8);
+		}
+	}
+
+	gsl_vector_free(gsl_eval);
+	gsl_matrix_free(m); gsl_matrix_free(gsl_evec);
+	gsl_eigen_symmv_free(workspace);
+}
+#endif
@@ -0,0 +1,180 @@
+#include "test.h"
+#include "surfaces.h"
+#include "../inc/math/simd_kernels.h"
+#include "../inc/graph/transformed_view.h"
+#include "../inc/parameters.h"
+#include <random>
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <glm/gtc/quaternion.hpp>
+
+//------------------------------------------------------
+//--------------------- INTERNAL -----------------------
+//------------------------------------------------------
+static std::vector<glm::dmat4> random_poses(int k, std::mt19937& rng)
+{
+	std::normal_distribution<double> normal;
+	std::uniform_real_distribution<double> value(-20.0, 20.0);
+
+	std::vector<glm::dmat4> poses;
+	for(int j = 0; j < k; j++)
+	{
+		double w = normal(rng), x = normal(rng), y = normal(rng), z = normal(rng);
+		double len = sqrt(w*w + x*x + y*y + z*z);
+		glm::dmat4 T = glm::mat4_cast( glm::dquat(w / len, x / len, y / len, z / len) );
+		T[3] = glm::dvec4(value(rng), value(rng), value(rng), 1.0);
+		poses.push_back(T);
+	}
+	return poses;
+}
+
+//All the poses applied to every node of G, at the current settings
+static void transform_all(const Graph& g, const std::vector<glm::dmat4>& poses,
+						  std::vector<glm::dvec3>& positions, std::vector<glm::dvec3>& normals)
+{
+	positions.assign(poses.size() * g.size(), glm::dvec3(0.0));
+	normals.assign(poses.size() * g.size(), glm::dvec3(0.0));
+	TransformedView::transform_poses(g, &poses[0], poses.size(), 0, g.size(), &positions[0], &normals[0]);
+}
+
+//Bitwise equality of N doubles
+static bool same_bits(const double* a, const double* b, size_t n)
+{
+	return memcmp(a, b, n * sizeof(double)) == 0;
+}
+
+//------------------------------------------------------
+//----------------------- TESTS ------------------------
+//------------------------------------------------------
+//corner_curvatures() and classify_convexity() give bitwise the scalar
+//results at every level the CPU supports. The surfaces have node and
+//face counts leaving tails for both vector widths, and the ranges also
+//start off a vector boundary.
+TEST(preprocessing_kernels_levels)
+{
+	const int SIZES[][2] = { { 7, 9 }, { 13, 21 }, { 30, 61 } };	//65, 275, 1832 nodes
+	const int saved = Parameters::SIMD_LEVEL;
+
+	for(unsigned int s = 0; s < sizeof(SIZES) / sizeof(SIZES[0]); s++)
+	{
+		Graph g;
+		sphere_surface(SIZES[s][0], SIZES[s][1], 10.0, g, 0.2, 3);
+		g.build_adjacency();
+		g.compute_curvatures();
+
+		const double* positions = &g.get_positions()[0].x;
+		const double* curvatures = &g.get_curvatures()[0].x;
+		const double centroid[3] = { 0.1, -0.2, 0.3 };
+		const int n = g.size(), n_faces = g.n_faces();
+
+		std::vector<int> faces(3 * n_faces);
+		for(int f = 0; f < n_faces; f++)
+		{
+			Face face = g.get_face(f);
+			faces[3*f] = face.a; faces[3*f + 1] = face.b; faces[3*f + 2] = face.c;
+		}
+
+		std::vector<double> scalar_corners(9 * n_faces), corners(9 * n_faces);
+		std::vector<Convexity> scalar_types(n), types(n);
+
+		for(int begin = 0; begin <= 3; begin += 3)
+		{
+			Parameters::SIMD_LEVEL = SIMD_SCALAR;
+			corner_curvatures(positions, faces.data(), begin, n_faces, scalar_corners.data());
+			classify_convexity(positions, curvatures, centroid, begin, n, scalar_types.data());
+
+			for(int level = SIMD_AVX2; level <= SIMD_AVX512; level++)
+			{
+				Parameters::SIMD_LEVEL = level;
+				if(simd_level() != level) break;
+
+				corner_curvatures(positions, faces.data(), begin, n_faces, corners.data());
+				classify_convexity(positions, curvatures, centroid, begin, n, types.data());
+
+				CHECK( same_bits(&scalar_corners[9*begin], &corners[9*begin], 9 * (n_faces - begin)) );
+				CHECK( std::equal(scalar_types.begin() + begin, scalar_types.end(), types.begin() + begin) );
+			}
+		}
+	}
+
+	Parameters::SIMD_LEVEL = saved;
+}
+
+//The documented bound: |approx_acos(x) - acos(x)| <= 2.2e-8 over [-1, 1],
+//with clamping outside and NaN propagated
+TEST(approx_acos_bound)
+{
+	const int N = 2000001;
+	double worst = 0.0;
+	for(int i = 0; i < N; i++)
+	{
+		double x = -1.0 + 2.0 * i / (N - 1);
+		worst = std::max(worst, fabs(approx_acos(x) - acos(x)));
+	}
+	CHECK( worst <= 2.2e-8 );
+
+	CHECK( approx_acos(1.5) == approx_acos(1.0) );
+	CHECK( approx_acos(-1.5) == approx_acos(-1.0) );
+	CHECK( std::isnan(approx_acos(std::nan(""))) );
+}
+
+//At every level, the exact kernels give bitwise what TransformedView
+//reads node by node, and the fused ones the same up to rounding (and
+//bitwise the same as each other). The node count leaves tails for both
+//vector widths.
+TEST(transform_points_levels)
+{
+	Graph g;
+	sphere_surface(31, 61, 10.0, g, 0.2, 3);
+
+	std::mt19937 rng(25);
+	std::vector<glm::dmat4> poses = random_poses(7, rng);
+
+	const int saved_level = Parameters::SIMD_LEVEL, saved_fused = Parameters::FUSED_TRANSFORMS;
+	std::vector<glm::dvec3> positions, normals, first_fused;
+
+	for(int level = SIMD_SCALAR; level <= SIMD_AVX512; level++)
+	{
+		Parameters::SIMD_LEVEL = level;
+		if(simd_level() != level) break;
+
+		for(int fused = 0; fused <= 1; fused++)
+		{
+			Parameters::FUSED_TRANSFORMS = fused;
+			transform_all(g, poses, positions, normals);
+
+			for(unsigned int j = 0; j < poses.size(); j++)
+			{
+				TransformedView view(g, poses[j]);
+				for(unsigned int i = 0; i < g.size(); i++)
+				{
+					const glm::dvec3 &p = positions[j*g.size() + i], &n = normals[j*g.size() + i];
+					const glm::dvec3 expected_p = view.get_pos(i), expected_n = view.get_normal(i);
+					for(int c = 0; c < 3; c++)
+					{
+						if(fused)
+						{
+							CHECK_NEAR(p[c], expected_p[c], 1e-12);
+							CHECK_NEAR(n[c], expected_n[c], 1e-14);
+						}
+						else
+						{
+							CHECK( p[c] == expected_p[c] );
+							CHECK( n[c] == expected_n[c] );
+						}
+					}
+				}
+			}
+
+			if(fused && level > SIMD_SCALAR)
+			{
+				if( first_fused.empty() ) first_fused = positions;
+				else CHECK( positions == first_fused );
+			}
+		}
+	}
+
+	Parameters::SIMD_LEVEL = saved_level;
+	Parameters::FUSED_TRANSFORMS = saved_fused;
+}